@@ -13,6 +13,9 @@ TEMPLATE = app
 INCLUDEPATH += /usr/local/include/bullet/
 LIBS += -L/usr/local/lib/ -lBulletSoftBody -lBulletDynamics -lBulletCollision -lLinearMath -lBox2D
 
+# qmake CONFIG+=alloc_counter counts heap allocations per thread
+alloc_counter: DEFINES += MAZE_ALLOC_COUNTER
+
 SOURCES += main.cpp\
         mainwindow.cpp \
     mazeview.cpp \
@@ -20,7 +23,34 @@ SOURCES += main.cpp\
     player.cpp \
     shader.cpp \
     minigame.cpp \
-    console.cpp
+    console.cpp \
+    wallgrid.cpp \
+    wallmesh.cpp \
+    wallsegments.cpp \
+    mazephysics.cpp \
+    physicsbackend.cpp \
+    box2dbackend.cpp \
+    gridcollider.cpp \
+    bulletworld.cpp \
+    options.cpp \
+    fixedtimestep.cpp \
+    simulation.cpp \
+    simulationthread.cpp \
+    portalvisibility.cpp \
+    minimap.cpp \
+    ellergenerator.cpp \
+    chunkedworld.cpp \
+    mazefile.cpp \
+    distancefield.cpp \
+    pathindex.cpp \
+    raycaster.cpp \
+    softwarerenderer.cpp \
+    inputlog.cpp \
+    profiler.cpp \
+    profilergraph.cpp \
+    allocationcounter.cpp \
+    framescheduler.cpp \
+    mouselatch.cpp
 
 HEADERS  += mainwindow.h \
     mazeview.h \
@@ -28,7 +58,38 @@ HEADERS  += mainwindow.h \
     player.h \
     shader.h \
     minigame.h \
-    console.h
+    console.h \
+    random.h \
+    wallgrid.h \
+    wallmesh.h \
+    wallsegments.h \
+    mazephysics.h \
+    physicsbackend.h \
+    box2dbackend.h \
+    gridcollider.h \
+    bulletworld.h \
+    options.h \
+    fixedtimestep.h \
+    spscqueue.h \
+    snapshotbuffer.h \
+    simulation.h \
+    simulationthread.h \
+    portalvisibility.h \
+    minimap.h \
+    ellergenerator.h \
+    chunkwalls.h \
+    chunkedworld.h \
+    mazefile.h \
+    distancefield.h \
+    pathindex.h \
+    raycaster.h \
+    softwarerenderer.h \
+    inputlog.h \
+    profiler.h \
+    profilergraph.h \
+    allocationcounter.h \
+    framescheduler.h \
+    mouselatch.h
 
 FORMS    += mainwindow.ui
 
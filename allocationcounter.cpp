@@ -0,0 +1,120 @@
+#include "allocationcounter.h"
+
+#ifdef MAZE_ALLOC_COUNTER
+
+#include <new>
+#include <stdlib.h>
+
+// plain thread locals, so counting never allocates itself
+static __thread quint64 threadAllocations = 0;
+static __thread quint64 threadBytes = 0;
+
+static inline void count(size_t size)
+{
+    threadAllocations++;
+    threadBytes += size;
+}
+
+#ifdef __GLIBC__
+
+// Below operator new, so Qt's containers and strings, which go to malloc
+// directly, are counted too.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* pointer, size_t size);
+
+void* malloc(size_t size)
+{
+    count(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t number, size_t size)
+{
+    count(number * size);
+    return __libc_calloc(number, size);
+}
+
+void* realloc(void* pointer, size_t size)
+{
+    if (size > 0)
+        count(size);
+    return __libc_realloc(pointer, size);
+}
+}
+
+#else
+
+void* operator new(size_t size)
+{
+    count(size);
+    if (void* pointer = malloc(size ? size : 1))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t &) throw()
+{
+    count(size);
+    return malloc(size ? size : 1);
+}
+
+void* operator new[](size_t size, const std::nothrow_t &) throw()
+{
+    count(size);
+    return malloc(size ? size : 1);
+}
+
+void operator delete(void* pointer) throw()
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer) throw()
+{
+    free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t &) throw()
+{
+    free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t &) throw()
+{
+    free(pointer);
+}
+
+#endif // __GLIBC__
+
+bool AllocationCounter::available()
+{
+    return true;
+}
+
+AllocationCount AllocationCounter::thread()
+{
+    AllocationCount result = { threadAllocations, threadBytes };
+    return result;
+}
+
+#else
+
+bool AllocationCounter::available()
+{
+    return false;
+}
+
+AllocationCount AllocationCounter::thread()
+{
+    AllocationCount result = { 0, 0 };
+    return result;
+}
+
+#endif // MAZE_ALLOC_COUNTER
@@ -0,0 +1,26 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+struct AllocationCount
+{
+    quint64 allocations;
+    quint64 bytes; // asked for, not counting the allocator's overhead
+};
+
+// Heap allocations made by each thread, for catching per-frame and per-step
+// allocations. Only counted in builds made with CONFIG += alloc_counter,
+// which replace malloc (with glibc) or global operator new with counting
+// versions; otherwise every count stays zero and costs nothing.
+class AllocationCounter
+{
+public:
+    // whether this build counts at all
+    static bool available();
+
+    // everything the calling thread allocated so far
+    static AllocationCount thread();
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,43 @@
+#-------------------------------------------------
+#
+# Benchmarks for the maze core, run outside the GUI
+#
+#-------------------------------------------------
+
+QT       += core gui opengl
+
+TARGET = maze-bench
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += ..
+LIBS += -L/usr/local/lib/ -lBox2D
+
+SOURCES += main.cpp \
+    benchreport.cpp \
+    ../maze.cpp \
+    ../wallgrid.cpp \
+    ../wallsegments.cpp \
+    ../mazephysics.cpp \
+    ../ellergenerator.cpp \
+    ../mazefile.cpp \
+    ../distancefield.cpp \
+    ../pathindex.cpp \
+    ../raycaster.cpp \
+    ../softwarerenderer.cpp \
+    ../wallmesh.cpp
+
+HEADERS  += benchreport.h \
+    ../maze.h \
+    ../random.h \
+    ../wallgrid.h \
+    ../wallsegments.h \
+    ../mazephysics.h \
+    ../ellergenerator.h \
+    ../mazefile.h \
+    ../distancefield.h \
+    ../pathindex.h \
+    ../raycaster.h \
+    ../softwarerenderer.h \
+    ../wallmesh.h
@@ -0,0 +1,101 @@
+#include "benchreport.h"
+
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Linux only: writing 5 to clear_refs sets VmHWM back to the current
+// resident size, ru_maxrss can only grow. What the last benchmark freed is
+// handed back first, or it would count as resident for the next one.
+void BenchReport::startBench()
+{
+#ifdef __GLIBC__
+    malloc_trim(0);
+#endif
+    std::ofstream clear("/proc/self/clear_refs");
+    clear << "5" << std::endl;
+    _peakReset = clear.good() && highWaterKb() > 0;
+}
+
+void BenchReport::add(const std::string &bench, const BenchValues &params, const BenchValues &metrics)
+{
+    Row row;
+    row.bench = bench;
+    row.params = params;
+    row.metrics = metrics;
+    if (_peakReset)
+        row.metrics.push_back(std::make_pair(std::string("peak_rss_kb"), (double)highWaterKb()));
+    else
+        row.metrics.push_back(std::make_pair(std::string("process_peak_rss_kb"), (double)peakRssKb()));
+    _rows.push_back(row);
+}
+
+long BenchReport::peakRssKb()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+    return usage.ru_maxrss; // kilobytes on Linux
+}
+
+long BenchReport::highWaterKb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return atol(line.c_str() + 6); // "VmHWM:   1234 kB"
+    }
+    return 0;
+}
+
+// JSON has no infinities or NaN
+static void writeValues(std::ostream &out, const BenchValues &values)
+{
+    out << "{";
+    for (size_t i = 0; i < values.size(); i++) {
+        out << (i ? ", " : "") << "\"" << values[i].first << "\": ";
+        if (std::isfinite(values[i].second))
+            out << values[i].second;
+        else
+            out << "null";
+    }
+    out << "}";
+}
+
+bool BenchReport::writeJson(const std::string &path) const
+{
+    std::ofstream out(path.c_str());
+    if (!out) {
+        std::cerr << "can't write " << path << std::endl;
+        return false;
+    }
+
+    out.precision(10);
+    out << "{\n  \"build\": \"" << __DATE__ << " " << __TIME__ << "\",\n"
+        << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+        << "  \"peak_rss_kb\": " << peakRssKb() << ",\n"
+        << "  \"results\": [";
+    for (size_t i = 0; i < _rows.size(); i++) {
+        const Row &row = _rows[i];
+        out << (i ? ",\n" : "\n") << "    {\"bench\": \"" << row.bench << "\", \"params\": ";
+        writeValues(out, row.params);
+        out << ", \"metrics\": ";
+        writeValues(out, row.metrics);
+        out << "}";
+    }
+    out << "\n  ]\n}\n";
+
+    if (!out) {
+        std::cerr << "failed writing " << path << std::endl;
+        return false;
+    }
+    return true;
+}
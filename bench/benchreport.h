@@ -0,0 +1,48 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// name and value pairs, in the order they are printed
+typedef std::vector<std::pair<std::string, double> > BenchValues;
+
+// Every row the benchmarks print, kept for writing out as JSON so runs of
+// different builds can be compared by a script. Each row also carries the
+// peak resident set size since its benchmark started, as peak_rss_kb, or
+// where the kernel can't reset the peak that of the whole process so far,
+// as process_peak_rss_kb.
+class BenchReport
+{
+public:
+    BenchReport() : _peakReset(false) {}
+
+    // before each benchmark, to measure its peak on its own
+    void startBench();
+
+    // params says what was run (size, seed, threads...), metrics what came out
+    void add(const std::string &bench, const BenchValues &params, const BenchValues &metrics);
+
+    // false if the file can't be written
+    bool writeJson(const std::string &path) const;
+
+    // of the whole process so far, in kilobytes
+    static long peakRssKb();
+
+private:
+    // since the last reset, 0 if it can't be read
+    static long highWaterKb();
+
+    struct Row
+    {
+        std::string bench;
+        BenchValues params;
+        BenchValues metrics;
+    };
+
+    std::vector<Row> _rows;
+    bool _peakReset; // highWaterKb() is this benchmark's own
+};
+
+#endif // BENCHREPORT_H
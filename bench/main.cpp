@@ -0,0 +1,691 @@
+#include "maze.h"
+#include "wallsegments.h"
+#include "mazephysics.h"
+#include "random.h"
+#include "ellergenerator.h"
+#include "distancefield.h"
+#include "pathindex.h"
+#include "raycaster.h"
+#include "softwarerenderer.h"
+#include "wallmesh.h"
+#include "benchreport.h"
+
+#include <QElapsedTimer>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <vector>
+
+// what the command line asked for, see main()
+struct BenchConfig
+{
+    BenchConfig() : seeds(1) {}
+
+    std::vector<int> sizes; // instead of each benchmark's own, if not empty
+    int seeds; // runs of the seeded benchmarks, one seed each
+    std::string json; // where to write the report, if anywhere
+};
+
+static BenchConfig config;
+static BenchReport report;
+
+static std::vector<int> sizes(std::initializer_list<int> defaults)
+{
+    return config.sizes.empty() ? std::vector<int>(defaults) : config.sizes;
+}
+
+static quint32 seed(int run)
+{
+    return DEFAULT_MAZE_SEED + run;
+}
+
+// somewhere for lookups to go so they aren't optimized away
+static volatile int lookupSink;
+
+static std::string sizeName(int size)
+{
+    return std::to_string(size) + "x" + std::to_string(size);
+}
+
+// generates square mazes of growing size; ns/cell should stay roughly flat
+void benchGeneration()
+{
+    const std::vector<int> SIZES = sizes({ 20, 64, 256, 1024, 2048, 4096 });
+
+    std::cout << "generation" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "seed" << std::setw(14) << "ms" << std::setw(14) << "ns/cell"
+              << std::setw(14) << "Mcells/s" << std::endl;
+    for (int size : SIZES) {
+        for (int run = 0; run < config.seeds; run++) {
+            // small mazes are too quick to time once
+            const int repeats = std::max(1, (256 * 256) / (size * size));
+
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < repeats; i++) {
+                Maze maze(size, size, seed(run));
+            }
+            const qint64 elapsed = timer.nsecsElapsed() / repeats;
+            const double cells = (double)size * size;
+
+            std::cout << std::setw(12) << sizeName(size) << std::setw(12) << seed(run)
+                      << std::setw(14) << std::fixed << std::setprecision(3) << elapsed * 1e-6
+                      << std::setw(14) << std::setprecision(1) << elapsed / cells
+                      << std::setw(14) << std::setprecision(1) << cells * 1e3 / elapsed << std::endl;
+            report.add("generation", { { "size", size }, { "seed", seed(run) } },
+                       { { "ms", elapsed * 1e-6 }, { "ns_per_cell", elapsed / cells }, { "cells_per_s", cells * 1e9 / elapsed } });
+        }
+    }
+}
+
+// Maze::cell() at random cells and across the whole maze, against the same
+// random cells through WallRow, over mazes from cache-sized to far bigger
+void benchLookup()
+{
+    const std::vector<int> SIZES = sizes({ 64, 1024, 4096 });
+    const int LOOKUPS = 1 << 22;
+
+    std::cout << "lookup" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "seed" << std::setw(14) << "random ns"
+              << std::setw(14) << "scan ns" << std::setw(14) << "row ns" << std::endl;
+    for (int size : SIZES) {
+        for (int run = 0; run < config.seeds; run++) {
+            Maze maze(size, size, seed(run));
+            Random random(seed(run));
+            std::vector<QPoint> cells(LOOKUPS);
+            for (int i = 0; i < LOOKUPS; i++)
+                cells[i] = QPoint(random.below(size), random.below(size));
+
+            QElapsedTimer timer;
+            timer.start();
+            for (int i = 0; i < LOOKUPS; i++)
+                lookupSink += maze.cell(cells[i].x(), cells[i].y()).up;
+            const double randomNs = timer.nsecsElapsed() / (double)LOOKUPS;
+
+            timer.restart();
+            for (int y = 0; y < size; y++) {
+                for (int x = 0; x < size; x++)
+                    lookupSink += maze.cell(x, y).up;
+            }
+            const double scanNs = timer.nsecsElapsed() / ((double)size * size);
+
+            timer.restart();
+            for (int i = 0; i < LOOKUPS; i++)
+                lookupSink += maze.row(cells[i].y()).mask(cells[i].x());
+            const double rowNs = timer.nsecsElapsed() / (double)LOOKUPS;
+
+            std::cout << std::setw(12) << sizeName(size) << std::setw(12) << seed(run)
+                      << std::setw(14) << std::fixed << std::setprecision(2) << randomNs
+                      << std::setw(14) << scanNs << std::setw(14) << rowNs << std::endl;
+            report.add("lookup", { { "size", size }, { "seed", seed(run) } },
+                       { { "random_ns_per_lookup", randomNs }, { "scan_ns_per_lookup", scanNs },
+                         { "row_ns_per_lookup", rowNs } });
+        }
+    }
+}
+
+// merged primitive counts and extraction time
+void benchSegments()
+{
+    const std::vector<int> SIZES = sizes({ 20, 64, 256, 1024 });
+
+    std::cout << "segments" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "ms" << std::setw(12) << "edges" << std::setw(12) << "segments"
+              << std::setw(12) << "faces" << std::setw(12) << "merged" << std::endl;
+    for (int size : SIZES) {
+        Maze maze(size, size);
+
+        QElapsedTimer timer;
+        timer.start();
+        WallSegments segments(maze);
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        std::cout << std::setw(12) << sizeName(size)
+                  << std::setw(12) << std::fixed << std::setprecision(3) << elapsed * 1e-6
+                  << std::setw(12) << segments.wallCount() << std::setw(12) << segments.segments().size()
+                  << std::setw(12) << segments.faceCount() << std::setw(12) << segments.faces().size() << std::endl;
+        report.add("segments", { { "size", size } },
+                   { { "ms", elapsed * 1e-6 }, { "edges", (double)segments.wallCount() },
+                     { "segments", (double)segments.segments().size() }, { "faces", (double)segments.faceCount() },
+                     { "merged", (double)segments.faces().size() } });
+    }
+}
+
+// the wall mesh's vertex and index arrays, without uploading them
+void benchMesh()
+{
+    const std::vector<int> SIZES = sizes({ 20, 64, 256, 1024 });
+
+    std::cout << "mesh" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "ms" << std::setw(14) << "Mcells/s"
+              << std::setw(12) << "vertices" << std::setw(12) << "indices" << std::endl;
+    for (int size : SIZES) {
+        Maze maze(size, size);
+        WallMesh mesh;
+
+        QElapsedTimer timer;
+        timer.start();
+        mesh.build(maze);
+        const qint64 elapsed = timer.nsecsElapsed();
+        const double cells = (double)size * size;
+
+        std::cout << std::setw(12) << sizeName(size)
+                  << std::setw(12) << std::fixed << std::setprecision(3) << elapsed * 1e-6
+                  << std::setw(14) << std::setprecision(2) << cells * 1e3 / elapsed
+                  << std::setw(12) << mesh.vertexCount() << std::setw(12) << mesh.indexCount() << std::endl;
+        report.add("mesh", { { "size", size } },
+                   { { "ms", elapsed * 1e-6 }, { "cells_per_s", cells * 1e9 / elapsed },
+                     { "vertices", (double)mesh.vertexCount() }, { "indices", (double)mesh.indexCount() } });
+    }
+}
+
+// a player-sized circle wandering the maze, the only dynamic body
+static double timeSteps(b2World* world, const Maze &maze, int steps)
+{
+    b2BodyDef playerDef;
+    playerDef.type = b2_dynamicBody;
+    playerDef.position.Set(0.5f * CELL_WIDTH, 0.5f * CELL_WIDTH);
+    b2Body* player = world->CreateBody(&playerDef);
+    b2CircleShape circle;
+    circle.m_radius = 0.5f; // PLAYER_RADIUS
+    b2FixtureDef fixtureDef;
+    fixtureDef.shape = &circle;
+    fixtureDef.density = 1.0f;
+    fixtureDef.friction = 0.0f;
+    player->CreateFixture(&fixtureDef);
+
+    Random random(maze.seed());
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < steps; i++) {
+        if (i % 30 == 0) {
+            const float angle = random.uniform() * 6.2831853f;
+            player->SetLinearVelocity(b2Vec2(2.0f * cosf(angle), 2.0f * sinf(angle)));
+        }
+        world->Step(1.0f / 120.0f, 6, 2);
+    }
+    return timer.nsecsElapsed() / (double)steps;
+}
+
+// world->Step cost against maze size, one edge per wall versus tiled chains
+void benchPhysics()
+{
+    const std::vector<int> SIZES = sizes({ 20, 64, 128, 256, 512 });
+    const int STEPS = 2000;
+
+    std::cout << "physics" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "seed" << std::setw(10) << "layout" << std::setw(12) << "build ms"
+              << std::setw(12) << "proxies" << std::setw(12) << "us/step" << std::setw(12) << "steps/s" << std::endl;
+    for (int size : SIZES) {
+        for (int run = 0; run < config.seeds; run++) {
+            Maze maze(size, size, seed(run));
+            for (int layout = 0; layout < 2; layout++) {
+                b2World world(b2Vec2(0.0f, 0.0f));
+
+                QElapsedTimer timer;
+                timer.start();
+                if (layout == 0)
+                    MazeBodyFactory::edgeBody(&world, maze);
+                else
+                    MazeBodyFactory::chainBodies(&world, maze);
+                const qint64 build = timer.nsecsElapsed();
+                const int proxies = world.GetProxyCount();
+
+                const double step = timeSteps(&world, maze, STEPS);
+
+                std::cout << std::setw(12) << sizeName(size) << std::setw(12) << seed(run)
+                          << std::setw(10) << (layout == 0 ? "edges" : "chains")
+                          << std::setw(12) << std::fixed << std::setprecision(3) << build * 1e-6
+                          << std::setw(12) << proxies
+                          << std::setw(12) << std::setprecision(2) << step * 1e-3
+                          << std::setw(12) << std::setprecision(0) << 1e9 / step << std::endl;
+                report.add(layout == 0 ? "physics_edges" : "physics_chains", { { "size", size }, { "seed", seed(run) } },
+                           { { "build_ms", build * 1e-6 }, { "proxies", (double)proxies },
+                             { "us_per_step", step * 1e-3 }, { "steps_per_s", 1e9 / step } });
+            }
+        }
+    }
+}
+
+// row-streamed generation of very tall mazes; nothing but the current row is
+// ever resident, so the cost per cell should not depend on the height
+void benchEller()
+{
+    const int WIDTHS[] = { 20, 256, 4096 };
+    const int CELLS = 1 << 24;
+
+    std::cout << "eller" << std::endl;
+    std::cout << std::setw(12) << "width" << std::setw(12) << "rows" << std::setw(14) << "ms"
+              << std::setw(14) << "ns/cell" << std::setw(14) << "first row us" << std::endl;
+    for (int width : WIDTHS) {
+        const int rows = CELLS / width;
+
+        QElapsedTimer timer;
+        timer.start();
+        EllerGenerator eller(width, DEFAULT_MAZE_SEED, rows);
+        eller.next();
+        const qint64 first = timer.nsecsElapsed();
+        while (!eller.atEnd())
+            eller.next();
+        const qint64 elapsed = timer.nsecsElapsed();
+
+        std::cout << std::setw(12) << width << std::setw(12) << rows
+                  << std::setw(14) << std::fixed << std::setprecision(3) << elapsed * 1e-6
+                  << std::setw(14) << std::setprecision(1) << elapsed / (double)CELLS
+                  << std::setw(14) << std::setprecision(1) << first * 1e-3 << std::endl;
+        report.add("eller", { { "width", width }, { "rows", rows } },
+                   { { "ms", elapsed * 1e-6 }, { "ns_per_cell", elapsed / (double)CELLS },
+                     { "cells_per_s", CELLS * 1e9 / elapsed }, { "first_row_us", first * 1e-3 } });
+    }
+}
+
+// saving and mapping a maze back in against generating it from scratch
+void benchFile()
+{
+    const std::vector<int> SIZES = sizes({ 1024, 4096, 10000 });
+
+    std::cout << "file" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(14) << "generate ms" << std::setw(12) << "save ms"
+              << std::setw(12) << "load ms" << std::setw(12) << "scan ms" << std::setw(12) << "MB" << std::endl;
+    for (int size : SIZES) {
+        const QString path = QDir::temp().filePath("maze-bench.maze");
+
+        QElapsedTimer timer;
+        timer.start();
+        Maze* maze = new Maze(size, size);
+        const qint64 generate = timer.nsecsElapsed();
+
+        timer.restart();
+        maze->save(path);
+        const qint64 save = timer.nsecsElapsed();
+        const double megabytes = (maze->walls().horizontalWords() + maze->walls().verticalWords()) * 8.0 / (1024 * 1024);
+        delete maze;
+
+        timer.restart();
+        Maze* loaded = Maze::load(path);
+        const qint64 load = timer.nsecsElapsed();
+
+        // touching every row pages the whole file in
+        timer.restart();
+        int walls = 0;
+        for (int y = 0; y < size; y++)
+            walls += loaded->row(y).mask(y % size) != 0;
+        const qint64 scan = timer.nsecsElapsed();
+        delete loaded;
+        QFile::remove(path);
+
+        std::cout << std::setw(12) << sizeName(size)
+                  << std::setw(14) << std::fixed << std::setprecision(3) << generate * 1e-6
+                  << std::setw(12) << save * 1e-6 << std::setw(12) << load * 1e-6
+                  << std::setw(12) << scan * 1e-6 << std::setw(12) << std::setprecision(1) << megabytes << std::endl;
+        report.add("file", { { "size", size } },
+                   { { "generate_ms", generate * 1e-6 }, { "save_ms", save * 1e-6 }, { "load_ms", load * 1e-6 },
+                     { "scan_ms", scan * 1e-6 }, { "megabytes", megabytes } });
+    }
+}
+
+// tiled generation from one thread up to every core; the walls have to come
+// out the same every time
+void benchParallel()
+{
+    const std::vector<int> SIZES = sizes({ 2048, 8192 });
+    const int cores = QThread::idealThreadCount();
+
+    std::cout << "parallel (" << cores << " cores)" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(10) << "threads" << std::setw(12) << "ms"
+              << std::setw(12) << "speedup" << std::setw(12) << "same" << std::endl;
+    for (int size : SIZES) {
+        double single = 0;
+        quint64 expected = 0;
+        for (int threads = 1; threads <= cores; threads = threads < cores ? std::min(cores, threads * 2) : cores + 1) {
+            QElapsedTimer timer;
+            timer.start();
+            Maze maze(size, size, DEFAULT_MAZE_SEED, threads);
+            const double ms = timer.nsecsElapsed() * 1e-6;
+
+            const quint64 hash = maze.wallHash();
+            if (threads == 1) {
+                single = ms;
+                expected = hash;
+            }
+
+            std::cout << std::setw(12) << sizeName(size)
+                      << std::setw(10) << threads
+                      << std::setw(12) << std::fixed << std::setprecision(1) << ms
+                      << std::setw(12) << std::setprecision(2) << single / ms
+                      << std::setw(12) << (hash == expected ? "yes" : "NO") << std::endl;
+            report.add("parallel", { { "size", size }, { "threads", threads } },
+                       { { "ms", ms }, { "cells_per_s", (double)size * size * 1e3 / ms }, { "speedup", single / ms },
+                         { "same", hash == expected } });
+        }
+    }
+}
+
+// distance fields over perfect mazes, and over the same mazes with some
+// loops knocked in so the breadth first fallback runs
+void benchDistance()
+{
+    const std::vector<int> SIZES = sizes({ 256, 1024, 4096 });
+
+    std::cout << "distance" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(8) << "loops" << std::setw(12) << "ms"
+              << std::setw(12) << "ns/cell" << std::setw(12) << "farthest" << std::endl;
+    for (int size : SIZES) {
+        Maze maze(size, size);
+        Random random(maze.seed());
+        const qint64 CELLS = (qint64)size * size;
+        for (int loops = 0; loops < 2; loops++) {
+            if (loops) {
+                for (int i = 0; i < size * 4; i++) {
+                    const QPoint cell(random.below(size - 1), random.below(size));
+                    maze.setWall(cell, cell + QPoint(1, 0), false);
+                }
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            DistanceField field(maze, QPoint(0, 0));
+            const qint64 elapsed = timer.nsecsElapsed();
+
+            std::cout << std::setw(12) << sizeName(size)
+                      << std::setw(8) << (loops ? "yes" : "no")
+                      << std::setw(12) << std::fixed << std::setprecision(1) << elapsed * 1e-6
+                      << std::setw(12) << std::setprecision(1) << elapsed / (double)CELLS
+                      << std::setw(12) << field.distance(field.farthest()) << std::endl;
+            report.add("distance", { { "size", size }, { "loops", loops } },
+                       { { "ms", elapsed * 1e-6 }, { "ns_per_cell", elapsed / (double)CELLS },
+                         { "farthest", (double)field.distance(field.farthest()) } });
+        }
+    }
+}
+
+// plain A* over every cell with the manhattan heuristic, for comparison;
+// the number of cells on the path, 0 if there is none
+static int flatPath(const Maze &maze, QPoint from, QPoint to)
+{
+    const int width = maze.width();
+    const int cells = width * maze.height();
+    QVector<quint32> cost(cells, 0xffffffff);
+    QVector<QPair<quint32, int> > open;
+    const int first = from.y() * width + from.x();
+    const int goal = to.y() * width + to.x();
+    cost[first] = 0;
+    open.append(qMakePair((quint32)(abs(from.x() - to.x()) + abs(from.y() - to.y())), first));
+    while (!open.isEmpty()) {
+        std::pop_heap(open.begin(), open.end(), std::greater<QPair<quint32, int> >());
+        const QPair<quint32, int> entry = open.last();
+        open.removeLast();
+        const int current = entry.second;
+        if (current == goal)
+            return cost[goal] + 1;
+        const int x = current % width;
+        const int y = current / width;
+        if (entry.first != cost[current] + abs(x - to.x()) + abs(y - to.y()))
+            continue;
+
+        const int walls = maze.row(y).mask(x);
+        const int steps[4] = { 1, -1, width, -width };
+        const int exits[4] = { WALL_RIGHT, WALL_LEFT, WALL_UP, WALL_DOWN };
+        for (int i = 0; i < 4; i++) {
+            if (walls & exits[i])
+                continue;
+            const int n = current + steps[i];
+            if (cost[n] <= cost[current] + 1)
+                continue;
+            cost[n] = cost[current] + 1;
+            const int nx = n % width;
+            const int ny = n / width;
+            open.append(qMakePair(cost[n] + abs(nx - to.x()) + abs(ny - to.y()), n));
+            std::push_heap(open.begin(), open.end(), std::greater<QPair<quint32, int> >());
+        }
+    }
+    return 0;
+}
+
+// point to point queries through the cluster index against flat A*, and
+// what keeping the index current costs when walls open up; the same queries
+// are checked again once the edits have made loops
+void benchPathing()
+{
+    const std::vector<int> SIZES = sizes({ 512, 2048 });
+    const int QUERIES = 50;
+    const int EDITS = 100;
+
+    std::cout << "pathing" << std::endl;
+    std::cout << std::setw(12) << "size" << std::setw(12) << "build ms" << std::setw(12) << "nodes"
+              << std::setw(12) << "hpa ms" << std::setw(12) << "flat ms" << std::setw(12) << "update ms"
+              << std::setw(8) << "same" << std::setw(8) << "edited" << std::endl;
+    for (int size : SIZES) {
+        Maze maze(size, size);
+        Random random(maze.seed());
+
+        QElapsedTimer timer;
+        timer.start();
+        PathIndex index(maze);
+        const qint64 build = timer.nsecsElapsed();
+
+        std::vector<std::pair<QPoint, QPoint>> queries;
+        for (int i = 0; i < QUERIES; i++)
+            queries.push_back(std::make_pair(QPoint(random.below(size), random.below(size)),
+                                             QPoint(random.below(size), random.below(size))));
+
+        qint64 hierarchical = 0;
+        qint64 flat = 0;
+        bool same = true;
+        for (const std::pair<QPoint, QPoint> &query : queries) {
+            timer.restart();
+            const int length = index.path(query.first, query.second).size();
+            hierarchical += timer.nsecsElapsed();
+
+            timer.restart();
+            const int flatLength = flatPath(maze, query.first, query.second);
+            flat += timer.nsecsElapsed();
+            same = same && flatLength == length;
+        }
+
+        timer.restart();
+        for (int i = 0; i < EDITS; i++) {
+            const QPoint cell(random.below(size - 1), random.below(size));
+            maze.setWall(cell, cell + QPoint(1, 0), false);
+            index.update(QRect(cell.x(), cell.y(), 2, 1));
+        }
+        const qint64 update = timer.nsecsElapsed();
+
+        // shortest paths now that there are several ways round
+        bool sameEdited = true;
+        for (const std::pair<QPoint, QPoint> &query : queries) {
+            const int length = index.path(query.first, query.second).size();
+            const int flatLength = flatPath(maze, query.first, query.second);
+            sameEdited = sameEdited && flatLength == length;
+        }
+
+        std::cout << std::setw(12) << sizeName(size)
+                  << std::setw(12) << std::fixed << std::setprecision(1) << build * 1e-6
+                  << std::setw(12) << index.nodeCount()
+                  << std::setw(12) << std::setprecision(3) << hierarchical * 1e-6 / QUERIES
+                  << std::setw(12) << flat * 1e-6 / QUERIES
+                  << std::setw(12) << update * 1e-6 / EDITS
+                  << std::setw(8) << (same ? "yes" : "NO") << std::setw(8) << (sameEdited ? "yes" : "NO") << std::endl;
+        report.add("pathing", { { "size", size } },
+                   { { "build_ms", build * 1e-6 }, { "nodes", (double)index.nodeCount() },
+                     { "hpa_ms", hierarchical * 1e-6 / QUERIES }, { "flat_ms", flat * 1e-6 / QUERIES },
+                     { "update_ms", update * 1e-6 / EDITS }, { "same", same }, { "same_edited", sameEdited } });
+    }
+}
+
+// batches of rays in random directions from random points, walked one at a
+// time and eight at a time; both have to agree
+void benchRaycast()
+{
+    const int SIZE = 512;
+    const int RAYS = 1 << 16;
+    const float DISTANCES[] = { 8.0f, 64.0f, 1e6f };
+
+    Maze maze(SIZE, SIZE);
+    WallRaycaster caster(maze);
+    Random random(maze.seed());
+
+    QVector<float> originX(RAYS), originY(RAYS), directionX(RAYS), directionY(RAYS);
+    for (int i = 0; i < RAYS; i++) {
+        originX[i] = random.uniform() * SIZE * CELL_WIDTH;
+        originY[i] = random.uniform() * SIZE * CELL_WIDTH;
+        const float angle = random.uniform() * 6.2831853f;
+        directionX[i] = cos(angle);
+        directionY[i] = sin(angle);
+    }
+    RayBatch rays = { originX.constData(), originY.constData(), directionX.constData(), directionY.constData(), RAYS };
+    QVector<RayHit> scalar(RAYS), batched(RAYS);
+
+    std::cout << "raycast (" << (WallRaycaster::vectorized() ? "avx2" : "scalar only") << ")" << std::endl;
+    std::cout << std::setw(12) << "max" << std::setw(14) << "scalar Mray/s" << std::setw(14) << "batch Mray/s"
+              << std::setw(12) << "speedup" << std::setw(8) << "same" << std::endl;
+    for (float distance : DISTANCES) {
+        QElapsedTimer timer;
+        timer.start();
+        caster.castScalar(rays, distance, scalar.data());
+        const qint64 one = timer.nsecsElapsed();
+
+        timer.restart();
+        caster.cast(rays, distance, batched.data());
+        const qint64 eight = timer.nsecsElapsed();
+
+        bool same = true;
+        for (int i = 0; i < RAYS; i++) {
+            same = same && scalar[i].distance == batched[i].distance && scalar[i].wall == batched[i].wall
+                   && scalar[i].x == batched[i].x && scalar[i].y == batched[i].y;
+        }
+
+        std::cout << std::setw(12) << std::setprecision(0) << std::fixed << distance
+                  << std::setw(14) << std::setprecision(1) << RAYS * 1e3 / one
+                  << std::setw(14) << RAYS * 1e3 / eight
+                  << std::setw(12) << std::setprecision(2) << (double)one / eight
+                  << std::setw(8) << (same ? "yes" : "NO") << std::endl;
+        report.add("raycast", { { "size", SIZE }, { "max_distance", distance } },
+                   { { "scalar_rays_per_s", RAYS * 1e9 / one }, { "batch_rays_per_s", RAYS * 1e9 / eight },
+                     { "vectorized", WallRaycaster::vectorized() }, { "same", same } });
+    }
+}
+
+// 1080p frames of the software renderer walking through a maze, from one
+// thread up to every core
+void benchRender()
+{
+    const int FRAMES = 60;
+    const int cores = QThread::idealThreadCount();
+
+    Maze maze(64, 64);
+    QImage image(1920, 1080, QImage::Format_RGB32);
+
+    std::cout << "render 1920x1080 (" << cores << " cores)" << std::endl;
+    std::cout << std::setw(10) << "threads" << std::setw(12) << "ms" << std::setw(12) << "fps" << std::endl;
+    for (int threads = 1; threads <= cores; threads = threads < cores ? std::min(cores, threads * 2) : cores + 1) {
+        SoftwareRenderer renderer(threads);
+        PlayerPose pose = { 1.0f, 1.0f, 0.0f };
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < FRAMES; i++) {
+            pose.angle = i * 0.1f;
+            renderer.render(image, maze, pose, 0.0f);
+        }
+        const double ms = timer.nsecsElapsed() * 1e-6 / FRAMES;
+
+        std::cout << std::setw(10) << threads
+                  << std::setw(12) << std::fixed << std::setprecision(2) << ms
+                  << std::setw(12) << std::setprecision(1) << 1000.0 / ms << std::endl;
+        report.add("render", { { "width", image.width() }, { "height", image.height() }, { "threads", threads } },
+                   { { "ms", ms }, { "fps", 1000.0 / ms } });
+    }
+}
+
+static void usage()
+{
+    std::cerr << "usage: maze-bench [name|all] [--sizes N,N,...] [--seeds N] [--json file]" << std::endl;
+}
+
+// comma separated, at least 2 each
+static bool parseSizes(const char* text, std::vector<int> &sizes)
+{
+    sizes.clear();
+    const std::string list(text);
+    size_t start = 0;
+    while (start <= list.size()) {
+        const size_t end = std::min(list.find(',', start), list.size());
+        const int size = atoi(list.substr(start, end - start).c_str());
+        if (size < 2)
+            return false;
+        sizes.push_back(size);
+        start = end + 1;
+    }
+    return !sizes.empty();
+}
+
+// which is a bench's name or all; resets the peak memory for the bench
+static bool runs(const char* which, const char* name)
+{
+    if (strcmp(which, "all") != 0 && strcmp(which, name) != 0)
+        return false;
+    report.startBench();
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    const char* which = "all";
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--sizes") == 0 && hasValue) {
+            if (!parseSizes(argv[++i], config.sizes)) {
+                usage();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--seeds") == 0 && hasValue) {
+            config.seeds = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--json") == 0 && hasValue) {
+            config.json = argv[++i];
+        } else if (argv[i][0] != '-') {
+            which = argv[i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (runs(which, "generation"))
+        benchGeneration();
+    if (runs(which, "lookup"))
+        benchLookup();
+    if (runs(which, "segments"))
+        benchSegments();
+    if (runs(which, "mesh"))
+        benchMesh();
+    if (runs(which, "physics"))
+        benchPhysics();
+    if (runs(which, "eller"))
+        benchEller();
+    if (runs(which, "file"))
+        benchFile();
+    if (runs(which, "parallel"))
+        benchParallel();
+    if (runs(which, "distance"))
+        benchDistance();
+    if (runs(which, "pathing"))
+        benchPathing();
+    if (runs(which, "raycast"))
+        benchRaycast();
+    if (runs(which, "render"))
+        benchRender();
+
+    std::cout << "peak RSS " << std::fixed << std::setprecision(1) << BenchReport::peakRssKb() / 1024.0 << " MB" << std::endl;
+    if (!config.json.empty() && !report.writeJson(config.json))
+        return 1;
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "box2dbackend.h"
+#include "mazephysics.h"
+#include "player.h"
+#include "chunkwalls.h"
+
+Box2DBackend::Box2DBackend(const Maze &maze)
+{
+    _world = new b2World(b2Vec2(0.0f, 0.0f)); // no gravity
+
+    // create the ground
+    b2BodyDef groundBodyDef;
+    groundBodyDef.position.Set(0.0f, -10.0f);
+    groundBody = _world->CreateBody(&groundBodyDef);
+    b2PolygonShape groundBox;
+    groundBox.SetAsBox(50.0f, 10.0f);
+    groundBody->CreateFixture(&groundBox, 0.0f);
+
+    // create the maze bodies
+    WallSegments segments(maze);
+    mazeBodies = MazeBodyFactory::chainBodies(_world, segments, QRect(0, 0, maze.width(), maze.height()));
+
+    // create the body
+    b2BodyDef bodyDef;
+    bodyDef.type = b2_dynamicBody; // can move
+    bodyDef.position.Set(0.0f, 40.0f);
+    body = _world->CreateBody(&bodyDef);
+    b2PolygonShape dynamicBox;
+    dynamicBox.SetAsBox(1.0f, 1.0f);
+    b2FixtureDef fixtureDef;
+    fixtureDef.shape = &dynamicBox; // is this a bug waiting to happen?
+    fixtureDef.density = 1.0f;
+    fixtureDef.friction = 0.3f;
+    body->CreateFixture(&fixtureDef);
+
+    // create the player
+    b2BodyDef playerDef;
+    playerDef.type = b2_dynamicBody;
+    playerDef.position.Set(0.5f, 0.5f);
+    playerBody = _world->CreateBody(&playerDef);
+    b2CircleShape circle;
+    circle.m_radius = PLAYER_RADIUS;
+    b2FixtureDef playerFixtureDef;
+    playerFixtureDef.shape = &circle; // is this a bug waiting to happen?
+    playerFixtureDef.density = 1.0f;
+    playerFixtureDef.friction = 0.0f;
+    playerBody->CreateFixture(&playerFixtureDef);
+    playerBody->SetLinearVelocity(b2Vec2(0,0));
+}
+
+Box2DBackend::~Box2DBackend()
+{
+    // the world owns and frees every body
+    delete _world;
+}
+
+void Box2DBackend::step(float seconds)
+{
+    _world->Step(seconds, 6, 2);
+}
+
+int Box2DBackend::propPositions(b2Vec2* positions, int max) const
+{
+    if (max < 1)
+        return 0;
+    positions[0] = body->GetPosition();
+    return 1;
+}
+
+static quint64 chunkKey(QPoint chunk)
+{
+    return ((quint64)(quint32)chunk.x() << 32) | (quint32)chunk.y();
+}
+
+bool Box2DBackend::addChunk(const ChunkWalls &walls)
+{
+    const Maze &maze = *walls.maze;
+    QVector<b2Body*> bodies = MazeBodyFactory::chainBodies(_world, *walls.segments, QRect(0, 0, maze.width(), maze.height()));
+
+    // the chains are in chunk cells, move them to where the chunk sits
+    const b2Vec2 origin(CELL_WIDTH * walls.origin.x(), CELL_WIDTH * walls.origin.y());
+    for (int i = 0; i < bodies.size(); i++)
+        bodies[i]->SetTransform(origin, 0.0f);
+
+    removeChunk(walls.chunk);
+    chunkBodies.insert(chunkKey(walls.chunk), bodies);
+    return true;
+}
+
+void Box2DBackend::removeChunk(QPoint chunk)
+{
+    const QVector<b2Body*> bodies = chunkBodies.take(chunkKey(chunk));
+    for (int i = 0; i < bodies.size(); i++)
+        _world->DestroyBody(bodies[i]);
+}
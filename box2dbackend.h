@@ -0,0 +1,41 @@
+#ifndef BOX2DBACKEND_H
+#define BOX2DBACKEND_H
+
+#include "physicsbackend.h"
+
+#include <QHash>
+
+// the full Box2D world: chain-shaped maze walls, the player circle and a test box
+class Box2DBackend : public PhysicsBackend
+{
+public:
+    explicit Box2DBackend(const Maze &maze);
+    ~Box2DBackend();
+
+    void step(float seconds);
+
+    b2Vec2 playerPosition() const { return playerBody->GetPosition(); }
+    float playerAngle() const { return playerBody->GetAngle(); }
+    b2Vec2 playerVelocity() const { return playerBody->GetLinearVelocity(); }
+    void setPlayerVelocity(b2Vec2 velocity) { playerBody->SetLinearVelocity(velocity); }
+    float playerAngularVelocity() const { return playerBody->GetAngularVelocity(); }
+    void setPlayerAngularVelocity(float velocity) { playerBody->SetAngularVelocity(velocity); }
+    void setPlayerTransform(b2Vec2 position, float angle) { playerBody->SetTransform(position, angle); }
+
+    int propPositions(b2Vec2* positions, int max) const;
+
+    bool addChunk(const ChunkWalls &walls);
+    void removeChunk(QPoint chunk);
+
+    b2World* world() { return _world; }
+
+private:
+    b2World* _world;
+    QVector<b2Body*> mazeBodies;
+    QHash<quint64, QVector<b2Body*> > chunkBodies;
+    b2Body* groundBody;
+    b2Body* body;
+    b2Body* playerBody;
+};
+
+#endif // BOX2DBACKEND_H
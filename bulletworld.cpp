@@ -0,0 +1,57 @@
+#include "bulletworld.h"
+
+// http://www.bulletphysics.org/mediawiki-1.5.8/index.php/Hello_World
+BulletWorld::BulletWorld()
+{
+    broadphase = new btDbvtBroadphase();
+    collisionConfiguration = new btDefaultCollisionConfiguration();
+    dispatcher = new btCollisionDispatcher(collisionConfiguration);
+    solver = new btSequentialImpulseConstraintSolver;
+    dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
+    dynamicsWorld->setGravity(btVector3(0, 0, -10));
+    groundShape = new btStaticPlaneShape(btVector3(0, 0, 1), 1);
+    fallShape = new btSphereShape(0.3f);
+
+    groundMotionState = new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1), btVector3(0, 0, -1)));
+    btRigidBody::btRigidBodyConstructionInfo groundRigidBodyCI(0, groundMotionState, groundShape, btVector3(0, 0, 0));
+    groundRigidBody = new btRigidBody(groundRigidBodyCI);
+    dynamicsWorld->addRigidBody(groundRigidBody);
+
+    fallMotionState = new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1), btVector3(0, 0, 50)));
+    btScalar mass = 1;
+    btVector3 fallInertia(0, 0, 0);
+    fallShape->calculateLocalInertia(mass, fallInertia);
+    btRigidBody::btRigidBodyConstructionInfo fallRigidBodyCI(mass, fallMotionState, fallShape, fallInertia);
+    fallRigidBody = new btRigidBody(fallRigidBodyCI);
+    dynamicsWorld->addRigidBody(fallRigidBody);
+}
+
+BulletWorld::~BulletWorld()
+{
+    dynamicsWorld->removeRigidBody(fallRigidBody);
+    dynamicsWorld->removeRigidBody(groundRigidBody);
+    delete fallRigidBody;
+    delete fallMotionState;
+    delete groundRigidBody;
+    delete groundMotionState;
+
+    delete dynamicsWorld;
+    delete solver;
+    delete dispatcher;
+    delete collisionConfiguration;
+    delete broadphase;
+    delete groundShape;
+    delete fallShape;
+}
+
+void BulletWorld::step(float seconds)
+{
+    dynamicsWorld->stepSimulation(seconds, 10);
+}
+
+btTransform BulletWorld::fallTransform() const
+{
+    btTransform trans;
+    fallRigidBody->getMotionState()->getWorldTransform(trans);
+    return trans;
+}
@@ -0,0 +1,30 @@
+#ifndef BULLETWORLD_H
+#define BULLETWORLD_H
+
+#include <btBulletDynamicsCommon.h>
+
+// the bullet hello-world scene: a sphere dropping onto a plane
+class BulletWorld
+{
+public:
+    BulletWorld();
+    ~BulletWorld();
+
+    void step(float seconds);
+    btTransform fallTransform() const;
+
+private:
+    btBroadphaseInterface* broadphase;
+    btDefaultCollisionConfiguration* collisionConfiguration;
+    btCollisionDispatcher* dispatcher;
+    btSequentialImpulseConstraintSolver* solver;
+    btDiscreteDynamicsWorld* dynamicsWorld;
+    btCollisionShape* groundShape;
+    btCollisionShape* fallShape;
+    btDefaultMotionState* groundMotionState;
+    btRigidBody* groundRigidBody;
+    btDefaultMotionState* fallMotionState;
+    btRigidBody* fallRigidBody;
+};
+
+#endif // BULLETWORLD_H
@@ -0,0 +1,259 @@
+#include "chunkedworld.h"
+#include "random.h"
+
+#include <QRunnable>
+#include <QMutexLocker>
+
+#include <algorithm>
+#include <stdlib.h>
+
+enum { LINK_NONE, LINK_EAST, LINK_NORTH };
+
+// a well mixed number for one chunk, the same on every thread and run
+static Random chunkRandom(quint32 seed, QPoint chunk, int salt)
+{
+    return Random(((quint64)seed << 32) ^ ((quint64)(quint32)chunk.x() * 0x9E3779B1ULL) ^
+                  ((quint64)(quint32)chunk.y() * 0x85EBCA77ULL << 16) ^ (quint64)salt);
+}
+
+// binary tree over the chunk grid: every chunk but the top right one opens
+// into exactly one of its east and north neighbours
+static int chunkLink(QPoint chunk, int chunksX, int chunksY, quint32 seed)
+{
+    const bool lastX = chunk.x() == chunksX - 1;
+    const bool lastY = chunk.y() == chunksY - 1;
+    if (lastX && lastY)
+        return LINK_NONE;
+    if (lastX)
+        return LINK_NORTH;
+    if (lastY)
+        return LINK_EAST;
+    return (chunkRandom(seed, chunk, 0).next() & 1) ? LINK_EAST : LINK_NORTH;
+}
+
+// where along its east or north seam a chunk opens
+static int seamOffset(QPoint chunk, int link, quint32 seed)
+{
+    return chunkRandom(seed, chunk, link).below(CHUNK_SIZE);
+}
+
+ChunkWalls ChunkedWorld::generate(QPoint chunk, int chunksX, int chunksY, quint32 seed)
+{
+    ChunkWalls walls;
+    walls.chunk = chunk;
+    walls.origin = QPoint(chunk.x() * CHUNK_SIZE, chunk.y() * CHUNK_SIZE);
+    walls.maze = QSharedPointer<Maze>(new Maze(CHUNK_SIZE, CHUNK_SIZE, chunkRandom(seed, chunk, 3).next()));
+
+    // open the seams this chunk shares with the tree
+    Maze &maze = *walls.maze;
+    const int last = CHUNK_SIZE - 1;
+    const int link = chunkLink(chunk, chunksX, chunksY, seed);
+    if (link == LINK_EAST) {
+        const int row = seamOffset(chunk, LINK_EAST, seed);
+        maze.setWall(QPoint(last, row), QPoint(CHUNK_SIZE, row), false);
+    } else if (link == LINK_NORTH) {
+        const int column = seamOffset(chunk, LINK_NORTH, seed);
+        maze.setWall(QPoint(column, last), QPoint(column, CHUNK_SIZE), false);
+    }
+
+    const QPoint west(chunk.x() - 1, chunk.y());
+    if (west.x() >= 0 && chunkLink(west, chunksX, chunksY, seed) == LINK_EAST) {
+        const int row = seamOffset(west, LINK_EAST, seed);
+        maze.setWall(QPoint(-1, row), QPoint(0, row), false);
+    }
+    const QPoint south(chunk.x(), chunk.y() - 1);
+    if (south.y() >= 0 && chunkLink(south, chunksX, chunksY, seed) == LINK_NORTH) {
+        const int column = seamOffset(south, LINK_NORTH, seed);
+        maze.setWall(QPoint(column, -1), QPoint(column, 0), false);
+    }
+
+    walls.segments = QSharedPointer<WallSegments>(new WallSegments(maze));
+    return walls;
+}
+
+// generates and meshes one chunk on the pool
+class ChunkJob : public QRunnable
+{
+public:
+    ChunkJob(ChunkedWorld* world, QPoint chunk) : world(world), chunk(chunk) {}
+
+    void run()
+    {
+        world->finished(build(world, chunk));
+    }
+
+    static ChunkedWorld::Chunk build(const ChunkedWorld* world, QPoint chunk)
+    {
+        ChunkedWorld::Chunk built;
+        built.walls = ChunkedWorld::generate(chunk, world->CHUNKS_X, world->CHUNKS_Y, world->SEED);
+        built.mesh = new WallMesh();
+        built.mesh->build(*built.walls.segments);
+        built.uploaded = false;
+        built.lastUsed = 0;
+
+        // wall bits, merged walls and the mesh (counted twice, it also lives on the GPU)
+        const WallGrid &grid = built.walls.maze->walls();
+        built.bytes = (qint64)grid.stride() * (2 * grid.height() + 5) * sizeof(quint64) +
+                built.walls.segments->segments().size() * sizeof(WallSegment) +
+                built.walls.segments->faces().size() * sizeof(WallFace) +
+                2 * (built.mesh->vertexCount() * sizeof(WallVertex) + built.mesh->indexCount() * sizeof(GLuint));
+        return built;
+    }
+
+private:
+    ChunkedWorld* world;
+    QPoint chunk;
+};
+
+ChunkedWorld::ChunkedWorld(int chunksX, int chunksY, quint32 seed, qint64 budget) :
+    CHUNKS_X(chunksX),
+    CHUNKS_Y(chunksY),
+    SEED(seed),
+    BUDGET(budget),
+    _bytes(0),
+    _frame(0),
+    _center(-1, -1)
+{
+}
+
+ChunkedWorld::~ChunkedWorld()
+{
+    _pool.clear();
+    _pool.waitForDone();
+
+    for (int i = 0; i < _finished.size(); i++)
+        delete _finished[i].mesh;
+    QHash<quint64, Chunk>::iterator it;
+    for (it = _chunks.begin(); it != _chunks.end(); ++it)
+        delete it->mesh;
+}
+
+void ChunkedWorld::finished(const Chunk &chunk)
+{
+    QMutexLocker locker(&_finishedLock);
+    _finished.append(chunk);
+}
+
+void ChunkedWorld::request(QPoint chunk)
+{
+    _pending.insert(key(chunk));
+    _pool.start(new ChunkJob(this, chunk));
+}
+
+void ChunkedWorld::post(bool added, const ChunkWalls &walls)
+{
+    ChunkEvent event;
+    event.added = added;
+    event.walls = walls;
+    _events.post(event);
+}
+
+// a pool result for a chunk already built on the spot comes too late
+void ChunkedWorld::add(const Chunk &chunk)
+{
+    const quint64 k = key(chunk.walls.chunk);
+    _pending.remove(k);
+    if (_chunks.contains(k)) {
+        delete chunk.mesh;
+        return;
+    }
+    _chunks.insert(k, chunk);
+    _bytes += chunk.bytes;
+    post(true, chunk.walls);
+}
+
+void ChunkedWorld::update(QPoint playerCell)
+{
+    _frame++;
+    _center = QPoint(std::max(0, std::min(CHUNKS_X - 1, playerCell.x() / CHUNK_SIZE)),
+                     std::max(0, std::min(CHUNKS_Y - 1, playerCell.y() / CHUNK_SIZE)));
+
+    QVector<Chunk> finished;
+    {
+        QMutexLocker locker(&_finishedLock);
+        finished.swap(_finished);
+    }
+    for (int i = 0; i < finished.size(); i++)
+        add(finished[i]);
+
+    // never wait for the chunk the player is standing in, even if the pool
+    // has it queued behind the others
+    if (!_chunks.contains(key(_center)))
+        add(ChunkJob::build(this, _center));
+
+    // ring by ring so the nearest chunks are queued first
+    for (int ring = 0; ring <= CHUNK_LOAD_RADIUS; ring++) {
+        for (int dy = -ring; dy <= ring; dy++) {
+            for (int dx = -ring; dx <= ring; dx++) {
+                if (std::max(abs(dx), abs(dy)) != ring)
+                    continue;
+                const QPoint chunk(_center.x() + dx, _center.y() + dy);
+                if (chunk.x() < 0 || chunk.y() < 0 || chunk.x() >= CHUNKS_X || chunk.y() >= CHUNKS_Y)
+                    continue;
+
+                const quint64 k = key(chunk);
+                QHash<quint64, Chunk>::iterator it = _chunks.find(k);
+                if (it != _chunks.end())
+                    it->lastUsed = _frame;
+                else if (!_pending.contains(k))
+                    request(chunk);
+            }
+        }
+    }
+
+    evict();
+}
+
+// drops the least recently used chunks until the budget fits again, but
+// never one around the player
+void ChunkedWorld::evict()
+{
+    while (_bytes > BUDGET) {
+        QHash<quint64, Chunk>::iterator oldest = _chunks.end();
+        QHash<quint64, Chunk>::iterator it;
+        for (it = _chunks.begin(); it != _chunks.end(); ++it) {
+            const QPoint chunk = it->walls.chunk;
+            if (std::max(abs(chunk.x() - _center.x()), abs(chunk.y() - _center.y())) <= CHUNK_LOAD_RADIUS)
+                continue;
+            if (oldest == _chunks.end() || it->lastUsed < oldest->lastUsed)
+                oldest = it;
+        }
+        if (oldest == _chunks.end())
+            break;
+
+        post(false, oldest->walls);
+        _bytes -= oldest->bytes;
+        delete oldest->mesh;
+        _chunks.erase(oldest);
+    }
+}
+
+void ChunkedWorld::draw()
+{
+    QHash<quint64, Chunk>::iterator it;
+    for (it = _chunks.begin(); it != _chunks.end(); ++it) {
+        if (it->lastUsed != _frame)
+            continue;
+        if (!it->uploaded) {
+            it->mesh->upload();
+            it->uploaded = true;
+        }
+
+        glPushMatrix();
+        glTranslatef(CELL_WIDTH * it->walls.origin.x(), CELL_WIDTH * it->walls.origin.y(), 0);
+        it->mesh->draw();
+        glPopMatrix();
+    }
+}
+
+int ChunkedWorld::walls(int x, int y) const
+{
+    const int all = WALL_UP | WALL_DOWN | WALL_LEFT | WALL_RIGHT;
+    if (x < 0 || y < 0 || x >= width() || y >= height())
+        return all;
+
+    QHash<quint64, Chunk>::const_iterator it = _chunks.find(key(QPoint(x / CHUNK_SIZE, y / CHUNK_SIZE)));
+    if (it == _chunks.end())
+        return all;
+    return it->walls.maze->row(y % CHUNK_SIZE).mask(x % CHUNK_SIZE);
+}
@@ -0,0 +1,92 @@
+#ifndef CHUNKEDWORLD_H
+#define CHUNKEDWORLD_H
+
+#include "chunkwalls.h"
+#include "wallmesh.h"
+
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QThreadPool>
+
+const int CHUNK_SIZE = 64; // cells per side
+const int CHUNK_LOAD_RADIUS = 2; // chunks kept around the player's chunk
+const qint64 CHUNK_MEMORY_BUDGET = 128 * 1024 * 1024; // bytes, the load radius alone takes about half
+
+// A maze of chunksX x chunksY chunks that is never built as a whole. Each
+// chunk is a perfect CHUNK_SIZE maze of its own, seeded from the world seed
+// and its position, and neighbouring chunks are joined by a single opening
+// on the seams of a binary tree over the chunk grid, so the world is a
+// perfect maze too and either side of a seam agrees on it without looking at
+// the other.
+//
+// update() runs on the GUI thread: it queues the chunks around the player on
+// a worker pool, which generates and meshes them, takes in whatever has
+// finished and evicts the least recently used chunks beyond the memory
+// budget. update(), draw() and the destructor need the GL context current,
+// they free the meshes of chunks going away. Physics changes are handed out as
+// ChunkEvents so the simulation can apply them on its own thread.
+class ChunkedWorld
+{
+public:
+    ChunkedWorld(int chunksX, int chunksY, quint32 seed = DEFAULT_MAZE_SEED, qint64 budget = CHUNK_MEMORY_BUDGET);
+    ~ChunkedWorld();
+
+    int width() const { return CHUNKS_X * CHUNK_SIZE; } // cells
+    int height() const { return CHUNKS_Y * CHUNK_SIZE; }
+
+    void update(QPoint playerCell);
+    void draw();
+
+    // WALL_* bits of a world cell; cells of chunks not in memory are solid
+    int walls(int x, int y) const;
+
+    // chunks added and evicted, for the physics
+    ChunkEventQueue* events() { return &_events; }
+
+    int residentChunks() const { return _chunks.size(); }
+    int pendingChunks() const { return _pending.size(); }
+    qint64 residentBytes() const { return _bytes; }
+
+    // builds a chunk from scratch, no state involved; safe on any thread
+    static ChunkWalls generate(QPoint chunk, int chunksX, int chunksY, quint32 seed);
+
+private:
+    struct Chunk
+    {
+        ChunkWalls walls;
+        WallMesh* mesh;
+        bool uploaded;
+        qint64 bytes;
+        quint64 lastUsed; // update() count when last within reach
+    };
+
+    friend class ChunkJob;
+    void finished(const Chunk &chunk);
+
+    static quint64 key(QPoint chunk) { return ((quint64)(quint32)chunk.x() << 32) | (quint32)chunk.y(); }
+    void request(QPoint chunk);
+    void evict();
+    void post(bool added, const ChunkWalls &walls);
+    void add(const Chunk &chunk);
+
+    const int CHUNKS_X;
+    const int CHUNKS_Y;
+    const quint32 SEED;
+    const qint64 BUDGET;
+
+    QThreadPool _pool;
+    QHash<quint64, Chunk> _chunks;
+    QSet<quint64> _pending;
+    qint64 _bytes;
+    quint64 _frame;
+    QPoint _center; // player's chunk at the last update
+
+    // filled by the workers, emptied by update()
+    QMutex _finishedLock;
+    QVector<Chunk> _finished;
+
+    ChunkEventQueue _events;
+};
+
+#endif // CHUNKEDWORLD_H
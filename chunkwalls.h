@@ -0,0 +1,54 @@
+#ifndef CHUNKWALLS_H
+#define CHUNKWALLS_H
+
+#include "maze.h"
+#include "wallsegments.h"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPoint>
+#include <QSharedPointer>
+#include <QVector>
+
+// the walls of one chunk of a ChunkedWorld, shared with the simulation
+// thread for physics
+struct ChunkWalls
+{
+    QPoint chunk;
+    QPoint origin; // cell of the chunk's bottom left corner
+    QSharedPointer<Maze> maze; // chunk-local cells
+    QSharedPointer<WallSegments> segments;
+};
+
+// a chunk arriving in or leaving the world
+struct ChunkEvent
+{
+    bool added;
+    ChunkWalls walls;
+};
+
+// Chunk changes from the GUI thread to whoever steps the physics. Chunks
+// only come and go every few seconds, so a plain lock is enough.
+class ChunkEventQueue
+{
+public:
+    void post(const ChunkEvent &event)
+    {
+        QMutexLocker locker(&_lock);
+        _events.append(event);
+    }
+
+    // everything posted since the last call
+    void take(QVector<ChunkEvent> &events)
+    {
+        QMutexLocker locker(&_lock);
+        events.swap(_events);
+        _events.clear();
+    }
+
+private:
+    QMutex _lock;
+    QVector<ChunkEvent> _events;
+};
+
+#endif // CHUNKWALLS_H
@@ -0,0 +1,173 @@
+#include "distancefield.h"
+
+DistanceField::DistanceField(const Maze &maze, QPoint source) : maze(maze), _source(source), _farthest(source)
+{
+    compute();
+}
+
+DistanceField::DistanceField(const Maze &maze, QPoint source, const quint32* distances) :
+    maze(maze),
+    _source(source),
+    _farthest(source),
+    _distances(distances)
+{
+    quint32 best = 0;
+    const int cells = maze.width() * maze.height();
+    for (int i = 0; i < cells; i++) {
+        if (distances[i] != UNREACHABLE && distances[i] > best) {
+            best = distances[i];
+            _farthest = QPoint(i % maze.width(), i / maze.width());
+        }
+    }
+}
+
+// the walls open from a cell, as neighbouring indices
+static inline int openNeighbours(const Maze &maze, int width, int current, int neighbours[4])
+{
+    const int y = current / width;
+    const int x = current - y * width;
+    const int walls = maze.row(y).mask(x);
+
+    int count = 0;
+    if (!(walls & WALL_RIGHT))
+        neighbours[count++] = current + 1;
+    if (!(walls & WALL_LEFT))
+        neighbours[count++] = current - 1;
+    if (!(walls & WALL_UP))
+        neighbours[count++] = current + width;
+    if (!(walls & WALL_DOWN))
+        neighbours[count++] = current - width;
+    return count;
+}
+
+void DistanceField::compute()
+{
+    const int width = maze.width();
+    const int height = maze.height();
+    const int cells = width * height;
+    _storage = QVector<quint32>(cells, UNREACHABLE);
+    _distances = _storage.constData();
+    if (_source.x() < 0 || _source.y() < 0 || _source.x() >= width || _source.y() >= height)
+        return;
+
+    const int first = _source.y() * width + _source.x();
+    if (!searchTree(first))
+        searchGraph(first);
+}
+
+// In a perfect maze the only path to a cell is the one any search finds, so
+// a depth first walk gives the same distances as breadth first, and it
+// follows corridors, which keeps its writes close together in memory. Gives
+// up as soon as it meets a loop.
+bool DistanceField::searchTree(int first)
+{
+    const int width = maze.width();
+    quint32* distances = _storage.data();
+
+    QVector<int> stack;
+    stack.reserve(1024);
+    stack.append(first);
+    distances[first] = 0;
+
+    quint32 best = 0;
+    int farthest = first;
+    while (!stack.isEmpty()) {
+        const int current = stack.last();
+        stack.removeLast();
+        const quint32 next = distances[current] + 1;
+        if (next - 1 > best) {
+            best = next - 1;
+            farthest = current;
+        }
+
+        // everything around but the way back has to be new
+        int neighbours[4];
+        const int count = openNeighbours(maze, width, current, neighbours);
+        int seen = 0;
+        for (int i = 0; i < count; i++) {
+            const int n = neighbours[i];
+            if (distances[n] != UNREACHABLE) {
+                if (++seen > (current == first ? 0 : 1)) {
+                    _storage.fill(UNREACHABLE);
+                    return false;
+                }
+                continue;
+            }
+            distances[n] = next;
+            stack.append(n);
+        }
+    }
+
+    _farthest = QPoint(farthest % width, farthest / width);
+    return true;
+}
+
+// plain breadth first search for mazes with loops
+void DistanceField::searchGraph(int first)
+{
+    const int width = maze.width();
+    const int cells = width * maze.height();
+    quint32* distances = _storage.data();
+    QVector<quint64> visited((cells + 63) / 64, 0);
+    QVector<int> queue(cells);
+
+    int head = 0;
+    int tail = 0;
+    queue[tail++] = first;
+    visited[first >> 6] |= 1ULL << (first & 63);
+    distances[first] = 0;
+
+    // one level of the search at a time, so nothing has to read a distance back
+    quint32 next = 1;
+    int levelEnd = tail;
+    while (head < tail) {
+        if (head == levelEnd) {
+            levelEnd = tail;
+            next++;
+        }
+        const int current = queue[head++];
+
+        int neighbours[4];
+        const int count = openNeighbours(maze, width, current, neighbours);
+        for (int i = 0; i < count; i++) {
+            const int n = neighbours[i];
+            quint64 &word = visited[n >> 6];
+            const quint64 bit = 1ULL << (n & 63);
+            if (word & bit)
+                continue;
+            word |= bit;
+            distances[n] = next;
+            queue[tail++] = n;
+        }
+    }
+
+    // the queue is in order of distance, so the last cell is the furthest
+    const int last = queue[tail - 1];
+    _farthest = QPoint(last % width, last / width);
+}
+
+quint32 DistanceField::distance(QPoint cell) const
+{
+    if (cell.x() < 0 || cell.y() < 0 || cell.x() >= maze.width() || cell.y() >= maze.height())
+        return UNREACHABLE;
+    return _distances[cell.y() * maze.width() + cell.x()];
+}
+
+QPoint DistanceField::nextStep(QPoint cell) const
+{
+    const quint32 d = distance(cell);
+    if (d == UNREACHABLE || d == 0)
+        return cell;
+
+    const int walls = maze.row(cell.y()).mask(cell.x());
+    const QPoint steps[4] = { QPoint(1, 0), QPoint(-1, 0), QPoint(0, 1), QPoint(0, -1) };
+    const int open[4] = { WALL_RIGHT, WALL_LEFT, WALL_UP, WALL_DOWN };
+    for (int i = 0; i < 4; i++) {
+        if (walls & open[i])
+            continue;
+        const QPoint n = cell + steps[i];
+        if (distance(n) == d - 1)
+            return n;
+    }
+    return cell;
+}
@@ -0,0 +1,50 @@
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include "maze.h"
+
+#include <QVector>
+#include <QPoint>
+
+const quint32 UNREACHABLE = 0xffffffff;
+
+// Steps from one source cell to every cell of a maze through the open walls.
+// Perfect mazes are walked depth first, anything with loops falls back to a
+// breadth first search from a flat queue with a visited bitset (one bit per
+// cell keeps the test in cache even for 16M cells). Either way building it
+// is a single linear pass, and afterwards every query is O(1).
+class DistanceField
+{
+public:
+    DistanceField(const Maze &maze, QPoint source);
+
+    // a field computed earlier, e.g. stored in a maze file; not copied, so it
+    // has to outlive this object
+    DistanceField(const Maze &maze, QPoint source, const quint32* distances);
+
+    QPoint source() const { return _source; }
+
+    // UNREACHABLE for cells cut off from the source or outside the maze
+    quint32 distance(QPoint cell) const;
+    const quint32* distances() const { return _distances; }
+
+    // the reachable cell furthest from the source (the source if it's alone)
+    QPoint farthest() const { return _farthest; }
+
+    // the neighbour of cell one step closer to the source, cell itself if it
+    // is the source or can't reach it
+    QPoint nextStep(QPoint cell) const;
+
+private:
+    void compute();
+    bool searchTree(int first);
+    void searchGraph(int first);
+
+    const Maze &maze;
+    QPoint _source;
+    QPoint _farthest;
+    QVector<quint32> _storage;
+    const quint32* _distances; // _storage or external
+};
+
+#endif // DISTANCEFIELD_H
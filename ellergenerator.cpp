@@ -0,0 +1,116 @@
+#include "ellergenerator.h"
+
+// chance of joining two neighbouring cells of different sets
+const float JOIN_CHANCE = 0.5f;
+// chance of a cell opening up into the next row (each set gets at least one)
+const float OPEN_CHANCE = 0.5f;
+
+static void clearBit(QVector<quint64> &words, int x)
+{
+    words[(x+1) >> 6] &= ~(1ULL << ((x+1) & 63));
+}
+
+EllerGenerator::EllerGenerator(int width, quint32 seed, int height) :
+    WIDTH(width),
+    HEIGHT(height),
+    _random(seed),
+    _y(0),
+    _finishing(false),
+    _done(width <= 0)
+{
+    // columns -1 through width+1, same as WallGrid
+    _stride = (width + 3 + 63) / 64;
+
+    _sets.resize(width);
+    _parent.resize(width);
+    _remaining.resize(width);
+    _remap.resize(width);
+    _opened.resize(width);
+    for (int x = 0; x < width; x++)
+        _sets[x] = x;
+
+    // the bottom border
+    _lines[0] = QVector<quint64>(_stride, ~0ULL);
+    _lines[1] = QVector<quint64>(_stride, ~0ULL);
+    _sides = QVector<quint64>(_stride, ~0ULL);
+    _below = 0;
+}
+
+int EllerGenerator::find(int label)
+{
+    while (_parent[label] != label) {
+        _parent[label] = _parent[_parent[label]];
+        label = _parent[label];
+    }
+    return label;
+}
+
+WallRow EllerGenerator::next()
+{
+    WallRow row;
+    if (_done) {
+        row.below = row.above = row.sides = _sides.constData();
+        return row;
+    }
+
+    const bool last = _finishing || (HEIGHT > 0 && _y == HEIGHT - 1);
+
+    // the old line above is now the one below
+    if (_y > 0)
+        _below ^= 1;
+    QVector<quint64> &above = _lines[_below ^ 1];
+    above.fill(~0ULL);
+    _sides.fill(~0ULL);
+
+    for (int label = 0; label < WIDTH; label++)
+        _parent[label] = label;
+
+    // join neighbours of different sets; the last row has to join them all
+    for (int x = 0; x < WIDTH - 1; x++) {
+        const int a = find(_sets[x]);
+        const int b = find(_sets[x+1]);
+        if (a != b && (last || _random.uniform() < JOIN_CHANCE)) {
+            _parent[b] = a;
+            clearBit(_sides, x+1);
+        }
+    }
+
+    if (!last) {
+        for (int x = 0; x < WIDTH; x++) {
+            _remaining[x] = 0;
+            _opened[x] = false;
+            _remap[x] = -1;
+        }
+        for (int x = 0; x < WIDTH; x++)
+            _remaining[find(_sets[x])]++;
+
+        // open some cells upwards, forcing the last cell of a set that
+        // hasn't opened yet, and relabel the next row densely: opened cells
+        // keep their set, the rest start new ones
+        int nextLabel = 0;
+        for (int x = 0; x < WIDTH; x++) {
+            const int root = find(_sets[x]);
+            bool open = _random.uniform() < OPEN_CHANCE;
+            if (--_remaining[root] == 0 && !_opened[root])
+                open = true;
+
+            if (open) {
+                clearBit(above, x);
+                _opened[root] = true;
+                if (_remap[root] < 0)
+                    _remap[root] = nextLabel++;
+                _sets[x] = _remap[root];
+            } else {
+                _sets[x] = nextLabel++;
+            }
+        }
+    } else {
+        _done = true;
+    }
+
+    row.below = _lines[_below].constData();
+    row.above = above.constData();
+    row.sides = _sides.constData();
+    _y++;
+    return row;
+}
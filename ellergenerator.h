@@ -0,0 +1,63 @@
+#ifndef ELLERGENERATOR_H
+#define ELLERGENERATOR_H
+
+#include "maze.h"
+#include "random.h"
+
+#include <QVector>
+
+// height of a maze that keeps going until finish() is called
+const int ELLER_UNBOUNDED = 0;
+
+// Eller's algorithm: a perfect maze produced one row at a time, bottom row
+// first, from nothing but the set each cell of the current row belongs to.
+// Memory depends only on the width, so mazes can be arbitrarily tall or
+// endless, and every row can be used as soon as next() returns it.
+//
+// Rows come out as WallRow views in the WallGrid bit layout (column x at bit
+// x+1, halo bits solid), so anything that reads Maze::row() can consume them.
+class EllerGenerator
+{
+public:
+    EllerGenerator(int width, quint32 seed = DEFAULT_MAZE_SEED, int height = ELLER_UNBOUNDED);
+
+    int width() const { return WIDTH; }
+    int height() const { return HEIGHT; }
+    int stride() const { return _stride; } // words per row
+
+    // rows handed out so far, i.e. the index of the next one
+    int rowIndex() const { return _y; }
+    bool atEnd() const { return _done; }
+
+    // generates the next row; the view stays valid until the following call
+    WallRow next();
+
+    // makes the next row the last one, closing off an unbounded maze
+    void finish() { _finishing = true; }
+
+private:
+    int find(int label);
+
+    const int WIDTH;
+    const int HEIGHT;
+    int _stride;
+
+    Random _random;
+    int _y;
+    bool _finishing;
+    bool _done;
+
+    // set label of every cell in the current row, labels stay below WIDTH
+    QVector<int> _sets;
+    // per-row union-find over the labels, plus scratch for the vertical pass
+    QVector<int> _parent;
+    QVector<int> _remaining;
+    QVector<int> _remap;
+    QVector<bool> _opened;
+
+    QVector<quint64> _lines[2]; // horizontal lines under and over the row, swapped every row
+    QVector<quint64> _sides; // vertical walls of the row
+    int _below; // which of _lines is under the current row
+};
+
+#endif // ELLERGENERATOR_H
@@ -0,0 +1,25 @@
+#include "fixedtimestep.h"
+
+FixedTimestep::FixedTimestep(double step, int maxSteps) :
+    _step(step),
+    _maxSteps(maxSteps),
+    _accumulator(0),
+    _dropped(0)
+{
+}
+
+int FixedTimestep::advance(double seconds)
+{
+    if (seconds > 0)
+        _accumulator += seconds;
+
+    int steps = (int)(_accumulator / _step);
+    _accumulator -= steps * _step;
+
+    if (steps > _maxSteps) {
+        _dropped += steps - _maxSteps;
+        steps = _maxSteps;
+    }
+
+    return steps;
+}
@@ -0,0 +1,33 @@
+#ifndef FIXEDTIMESTEP_H
+#define FIXEDTIMESTEP_H
+
+const double SIMULATION_STEP = 1.0 / 120.0; // seconds
+const int MAX_CATCH_UP_STEPS = 8;
+
+// Turns the real time between frames into a whole number of fixed-size
+// simulation steps. Time left over carries into the next frame, and after a
+// stall at most MAX_CATCH_UP_STEPS are run, the rest is dropped.
+class FixedTimestep
+{
+public:
+    FixedTimestep(double step = SIMULATION_STEP, int maxSteps = MAX_CATCH_UP_STEPS);
+
+    // add the real time that passed, returns the steps to run now
+    int advance(double seconds);
+
+    double step() const { return _step; }
+
+    // where the present sits between the last two steps, 0 to 1
+    float alpha() const { return (float)(_accumulator / _step); }
+
+    // steps thrown away by the catch-up cap so far
+    long droppedSteps() const { return _dropped; }
+
+private:
+    double _step;
+    int _maxSteps;
+    double _accumulator;
+    long _dropped;
+};
+
+#endif // FIXEDTIMESTEP_H
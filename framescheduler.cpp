@@ -0,0 +1,155 @@
+#include "framescheduler.h"
+
+#include <QGLWidget>
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+
+static const qint64 REPORT_INTERVAL = 5000000000LL; // ns between printed statistics
+static const double VSYNC_MIN_INTERVAL = 2.0; // ms, swaps coming back sooner aren't waiting for the display
+static const int VSYNC_FALLBACK_FPS = 60;
+
+FrameScheduler::FrameScheduler(QGLWidget* view, Mode mode, int fps, bool report, QObject *parent) :
+    QObject(parent),
+    _view(view),
+    _mode(mode),
+    _period(1000000000LL / std::max(1, fps)),
+    _report(report),
+    _frameStart(-1),
+    _deadline(0),
+    _lastReport(0),
+    _frames(0)
+{
+    memset(_intervals, 0, sizeof(_intervals));
+    memset(_work, 0, sizeof(_work));
+
+    _timer.setSingleShot(true);
+    _timer.setTimerType(Qt::PreciseTimer);
+    connect(&_timer, SIGNAL(timeout()), this, SLOT(tick()));
+    _clock.start();
+}
+
+FrameScheduler::~FrameScheduler()
+{
+    if (_report)
+        report();
+}
+
+FrameScheduler::Mode FrameScheduler::modeNamed(const QString &name)
+{
+    if (name == "ondemand")
+        return ON_DEMAND;
+    if (name == "vsync")
+        return VSYNC;
+    return CAPPED;
+}
+
+void FrameScheduler::frameStarted()
+{
+    const qint64 now = _clock.nsecsElapsed();
+    if (_frameStart >= 0)
+        _intervals[_frames % FRAME_STATS_WINDOW] = now - _frameStart;
+    _frameStart = now;
+}
+
+void FrameScheduler::frameFinished()
+{
+    const qint64 now = _clock.nsecsElapsed();
+    _work[_frames % FRAME_STATS_WINDOW] = now - _frameStart;
+    _frames++;
+
+    if (_report && now - _lastReport >= REPORT_INTERVAL) {
+        _lastReport = now;
+        report();
+    }
+
+    // a driver that ignores the swap interval would have us spinning
+    if (_mode == VSYNC && _frames == FRAME_STATS_WINDOW && stats().meanInterval < VSYNC_MIN_INTERVAL) {
+        std::cerr << "swaps don't wait for vsync, capping at " << VSYNC_FALLBACK_FPS << " fps" << std::endl;
+        _mode = CAPPED;
+        _period = 1000000000LL / VSYNC_FALLBACK_FPS;
+    }
+
+    if (_mode == VSYNC) {
+        // the swap already waited
+        _timer.start(0);
+    } else if (_mode == CAPPED) {
+        // Deadlines a period apart, not a period after each frame, so the
+        // timer's ms resolution and lateness never add up and the mean rate
+        // is fps even when a period is shorter than a ms. Only a deadline
+        // more than a period behind (a slow frame, a hidden window) starts
+        // over from this frame. Never slept off on the GUI thread, which has
+        // input to take meanwhile.
+        _deadline += _period;
+        if (_deadline < now - _period)
+            _deadline = _frameStart + _period;
+        const qint64 wait = _deadline - now;
+        _timer.start(wait > 0 ? (int)((wait + 500000) / 1000000) : 0);
+    }
+}
+
+void FrameScheduler::requestFrame()
+{
+    if (_mode == ON_DEMAND)
+        _view->update();
+}
+
+void FrameScheduler::tick()
+{
+    // painted right away rather than posted, so the deadline holds; a
+    // hidden view stops the chain until it's shown and painted again
+    if (_view->isVisible())
+        _view->updateGL();
+}
+
+FrameStats FrameScheduler::stats() const
+{
+    FrameStats stats;
+    stats.frames = _frames;
+    stats.meanInterval = 0.0;
+    stats.p99Interval = 0.0;
+    stats.worstInterval = 0.0;
+    stats.meanWork = 0.0;
+    stats.busy = 0.0;
+
+    // the first frame has no interval before it
+    qint64 sorted[FRAME_STATS_WINDOW];
+    int intervals = 0;
+    qint64 intervalSum = 0;
+    for (int frame = std::max(1, _frames - FRAME_STATS_WINDOW); frame < _frames; frame++) {
+        sorted[intervals] = _intervals[frame % FRAME_STATS_WINDOW];
+        intervalSum += sorted[intervals];
+        intervals++;
+    }
+
+    int works = 0;
+    qint64 workSum = 0;
+    for (int frame = std::max(0, _frames - FRAME_STATS_WINDOW); frame < _frames; frame++) {
+        workSum += _work[frame % FRAME_STATS_WINDOW];
+        works++;
+    }
+    if (works > 0)
+        stats.meanWork = workSum * 1e-6 / works;
+
+    if (intervals > 0) {
+        std::sort(sorted, sorted + intervals);
+        stats.meanInterval = intervalSum * 1e-6 / intervals;
+        stats.p99Interval = sorted[std::min(intervals - 1, intervals * 99 / 100)] * 1e-6;
+        stats.worstInterval = sorted[intervals - 1] * 1e-6;
+        stats.busy = std::min(1.0, stats.meanWork / stats.meanInterval);
+    }
+    return stats;
+}
+
+void FrameScheduler::report() const
+{
+    const FrameStats s = stats();
+    const double fps = s.meanInterval > 0.0 ? 1000.0 / s.meanInterval : 0.0;
+    std::cout << std::fixed << std::setprecision(2)
+              << "frames " << s.frames << " in " << _clock.elapsed() * 1e-3 << " s, interval mean "
+              << s.meanInterval << " ms (" << std::setprecision(1) << fps << " fps), p99 " << std::setprecision(2)
+              << s.p99Interval << ", max " << s.worstInterval << ", painting " << s.meanWork << " ms, "
+              << std::setprecision(0) << s.busy * 100.0 << "% busy" << std::endl;
+}
@@ -0,0 +1,74 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+class QGLWidget;
+
+const int FRAME_STATS_WINDOW = 240; // newest frames the statistics cover
+
+// over the newest FRAME_STATS_WINDOW frames, all times in ms
+struct FrameStats
+{
+    int frames; // painted since the start
+    double meanInterval; // from the start of one frame to the next
+    double p99Interval;
+    double worstInterval;
+    double meanWork; // spent painting and swapping
+    double busy; // fraction of the time between frames spent painting
+};
+
+// Decides when the view paints next, instead of a fixed repaint timer.
+//  ondemand: only when requestFrame() says something changed
+//  vsync: one frame after another, each swap waiting for the display
+//  capped: at most fps frames a second, each on a precise timer
+// The view calls frameStarted() and frameFinished() around every paint,
+// however it was asked for.
+class FrameScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Mode { ON_DEMAND, VSYNC, CAPPED };
+
+    // report prints the statistics every few seconds and on exit
+    FrameScheduler(QGLWidget* view, Mode mode, int fps, bool report, QObject *parent = 0);
+    ~FrameScheduler();
+
+    // "ondemand", "vsync" or "capped", with capped for anything else
+    static Mode modeNamed(const QString &name);
+    Mode mode() const { return _mode; }
+
+    void frameStarted();
+    void frameFinished();
+
+    FrameStats stats() const;
+
+public slots:
+    // input or the simulation changed what's on screen; only ondemand
+    // paints for it, the other modes paint anyway
+    void requestFrame();
+
+private slots:
+    void tick();
+
+private:
+    void report() const;
+
+    QGLWidget* _view;
+    Mode _mode;
+    qint64 _period; // ns between capped frames
+    bool _report;
+    QTimer _timer;
+    QElapsedTimer _clock;
+    qint64 _frameStart; // ns on _clock, -1 before the first frame
+    qint64 _deadline; // when the next capped frame is due
+    qint64 _lastReport;
+    int _frames;
+    qint64 _intervals[FRAME_STATS_WINDOW]; // ns, ring indexed by frame
+    qint64 _work[FRAME_STATS_WINDOW];
+};
+
+#endif // FRAMESCHEDULER_H
@@ -0,0 +1,66 @@
+#include "gridcollider.h"
+#include "player.h"
+
+#include <math.h>
+#include <algorithm>
+
+// pushes resolved per step; two is enough to settle into a corner
+const int COLLISION_PASSES = 2;
+
+GridCollider::GridCollider(const Maze &maze) :
+    maze(maze),
+    position(0.5f, 0.5f),
+    velocity(0.0f, 0.0f),
+    angle(0.0f),
+    angularVelocity(0.0f)
+{
+}
+
+void GridCollider::step(float seconds)
+{
+    angle += angularVelocity * seconds;
+    position += seconds * velocity;
+
+    for (int pass = 0; pass < COLLISION_PASSES; pass++) {
+        // keep the lookups inside the wall grid's halo
+        const int cx = std::max(0, std::min(maze.width() - 1, (int)floorf(position.x / CELL_WIDTH)));
+        const int cy = std::max(0, std::min(maze.height() - 1, (int)floorf(position.y / CELL_WIDTH)));
+        const WallGrid &walls = maze.walls();
+
+        // horizontal walls bounding the 3x3 block
+        for (int y = cy - 1; y <= cy + 2; y++) {
+            for (int x = cx - 1; x <= cx + 1; x++) {
+                if (walls.horizontal(x, y))
+                    collide(b2Vec2(CELL_WIDTH * x, CELL_WIDTH * y), b2Vec2(CELL_WIDTH * (x+1), CELL_WIDTH * y));
+            }
+        }
+
+        // vertical ones
+        for (int y = cy - 1; y <= cy + 1; y++) {
+            for (int x = cx - 1; x <= cx + 2; x++) {
+                if (walls.vertical(x, y))
+                    collide(b2Vec2(CELL_WIDTH * x, CELL_WIDTH * y), b2Vec2(CELL_WIDTH * x, CELL_WIDTH * (y+1)));
+            }
+        }
+    }
+}
+
+// push the disc off one wall and drop the part of its velocity heading into it
+void GridCollider::collide(b2Vec2 from, b2Vec2 to)
+{
+    const b2Vec2 wall = to - from;
+    const float t = std::max(0.0f, std::min(1.0f, b2Dot(position - from, wall) / b2Dot(wall, wall)));
+    const b2Vec2 closest = from + t * wall;
+
+    b2Vec2 normal = position - closest;
+    const float distance = normal.Length();
+    if (distance >= PLAYER_RADIUS || distance < 1e-6f)
+        return;
+
+    normal *= 1.0f / distance;
+    position += (PLAYER_RADIUS - distance) * normal;
+
+    const float into = b2Dot(velocity, normal);
+    if (into < 0.0f)
+        velocity -= into * normal;
+}
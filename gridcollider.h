@@ -0,0 +1,35 @@
+#ifndef GRIDCOLLIDER_H
+#define GRIDCOLLIDER_H
+
+#include "physicsbackend.h"
+
+// Moves the player disc by its velocities and pushes it back out of the walls
+// of the 3x3 cells around it, read straight from the maze's wall bits. Each
+// step costs the same no matter how big the maze is.
+class GridCollider : public PhysicsBackend
+{
+public:
+    explicit GridCollider(const Maze &maze);
+
+    void step(float seconds);
+
+    b2Vec2 playerPosition() const { return position; }
+    float playerAngle() const { return angle; }
+    b2Vec2 playerVelocity() const { return velocity; }
+    void setPlayerVelocity(b2Vec2 v) { velocity = v; }
+    float playerAngularVelocity() const { return angularVelocity; }
+    void setPlayerAngularVelocity(float v) { angularVelocity = v; }
+    void setPlayerTransform(b2Vec2 p, float a) { position = p; angle = a; }
+
+private:
+    void collide(b2Vec2 from, b2Vec2 to);
+
+    const Maze &maze;
+
+    b2Vec2 position;
+    b2Vec2 velocity;
+    float angle;
+    float angularVelocity;
+};
+
+#endif // GRIDCOLLIDER_H
@@ -0,0 +1,57 @@
+#-------------------------------------------------
+#
+# The game without a window: many simulated sessions
+# stepped as fast as the cores allow
+#
+#-------------------------------------------------
+
+QT       += core gui
+
+TARGET = maze-headless
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+TEMPLATE = app
+
+INCLUDEPATH += .. /usr/local/include/bullet/
+LIBS += -L/usr/local/lib/ -lBulletSoftBody -lBulletDynamics -lBulletCollision -lLinearMath -lBox2D
+
+# qmake CONFIG+=alloc_counter counts heap allocations per thread
+alloc_counter: DEFINES += MAZE_ALLOC_COUNTER
+
+SOURCES += main.cpp \
+    ../maze.cpp \
+    ../wallgrid.cpp \
+    ../wallsegments.cpp \
+    ../mazefile.cpp \
+    ../mazephysics.cpp \
+    ../physicsbackend.cpp \
+    ../box2dbackend.cpp \
+    ../gridcollider.cpp \
+    ../bulletworld.cpp \
+    ../distancefield.cpp \
+    ../simulation.cpp \
+    ../inputlog.cpp \
+    ../profiler.cpp \
+    ../allocationcounter.cpp \
+    ../raycaster.cpp \
+    ../softwarerenderer.cpp
+
+HEADERS  += ../maze.h \
+    ../random.h \
+    ../wallgrid.h \
+    ../wallsegments.h \
+    ../mazefile.h \
+    ../mazephysics.h \
+    ../physicsbackend.h \
+    ../box2dbackend.h \
+    ../gridcollider.h \
+    ../bulletworld.h \
+    ../distancefield.h \
+    ../chunkwalls.h \
+    ../player.h \
+    ../simulation.h \
+    ../inputlog.h \
+    ../profiler.h \
+    ../allocationcounter.h \
+    ../raycaster.h \
+    ../softwarerenderer.h
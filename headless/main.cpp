@@ -0,0 +1,458 @@
+#include "maze.h"
+#include "simulation.h"
+#include "fixedtimestep.h"
+#include "random.h"
+#include "inputlog.h"
+#include "profiler.h"
+#include "allocationcounter.h"
+#include "softwarerenderer.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImage>
+#include <QRunnable>
+#include <QScopedPointer>
+#include <QSize>
+#include <QThreadPool>
+#include <QVector>
+
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <math.h>
+
+struct HeadlessOptions
+{
+    int sessions;
+    int steps; // per session, at SIMULATION_STEP each
+    int size; // cells per side of every session's maze
+    QString physics;
+    QString input; // "seek" or "wander"
+
+    QString replay; // input log to run instead of the sessions
+    QString mazeFile; // the maze the log was recorded in, if not generated
+    int trace; // print the pose every this many replayed steps, 0 for never
+    QString profileTrace; // Chrome trace of the replay's last zones
+
+    QString render; // PNG of the last step's view, for one session or the replay
+    QSize renderSize;
+    int renderEvery; // also a numbered PNG every this many steps, 0 for never
+};
+
+struct SessionResult
+{
+    int steps;
+    bool reachedGoal;
+};
+
+// Scripted players. Both only press and release keys through
+// Simulation::handle(), the same events the window would send.
+class Driver
+{
+public:
+    explicit Driver(quint64 seed) : held(0), random(seed), nextChange(0) {}
+
+    // heads for the next cell on the shortest way to the goal
+    void seek(Simulation &simulation)
+    {
+        const PlayerPose pose = simulation.pose();
+        const QPoint hint = simulation.hint();
+        const float targetX = CELL_WIDTH * (hint.x() + 0.5f);
+        const float targetY = CELL_WIDTH * (hint.y() + 0.5f);
+
+        float turn = atan2(targetY - pose.y, targetX - pose.x) - pose.angle;
+        turn = remainder(turn, 2.0f * (float)M_PI);
+
+        int keys = 0;
+        if (turn > 0.1f)
+            keys |= KEY_TURN_LEFT;
+        else if (turn < -0.1f)
+            keys |= KEY_TURN_RIGHT;
+        if (fabs(turn) < 0.5f)
+            keys |= KEY_FORWARD;
+        hold(simulation, keys);
+    }
+
+    // whichever of the two input names
+    void drive(Simulation &simulation, const QString &input, int step)
+    {
+        if (input == "seek")
+            seek(simulation);
+        else
+            wander(simulation, step);
+    }
+
+    // a random set of keys every so often
+    void wander(Simulation &simulation, int step)
+    {
+        if (step < nextChange)
+            return;
+        nextChange = step + 10 + random.below(110);
+        static const int CHOICES[] = { KEY_FORWARD, KEY_FORWARD | KEY_TURN_LEFT, KEY_FORWARD | KEY_TURN_RIGHT,
+                                       KEY_TURN_LEFT, KEY_TURN_RIGHT, KEY_BACK, KEY_STRAFE_LEFT, KEY_STRAFE_RIGHT };
+        hold(simulation, CHOICES[random.below(8)]);
+    }
+
+private:
+    // key events for whatever changed since last time
+    void hold(Simulation &simulation, int keys)
+    {
+        for (int bit = 1; bit <= KEY_STRAFE_RIGHT; bit <<= 1) {
+            if ((keys & bit) == (held & bit))
+                continue;
+            InputEvent event;
+            event.type = (keys & bit) ? InputEvent::KEY_DOWN : InputEvent::KEY_UP;
+            event.key = bit;
+            event.dx = event.dy = 0;
+            event.sequence = 0;
+            simulation.handle(event);
+        }
+        held = keys;
+    }
+
+    int held;
+    Random random;
+    int nextChange;
+};
+
+// one player in one maze from start to goal, or until it runs out of steps
+class SessionJob : public QRunnable
+{
+public:
+    SessionJob(const HeadlessOptions &options, int session, SessionResult* result) :
+        options(options), session(session), result(result) {}
+
+    void run()
+    {
+        Maze maze(options.size, options.size, DEFAULT_MAZE_SEED + session);
+        Simulation simulation(maze, options.physics);
+        Driver driver(DEFAULT_MAZE_SEED ^ ((quint64)session << 32));
+
+        result->steps = 0;
+        result->reachedGoal = false;
+        for (int step = 0; step < options.steps; step++) {
+            driver.drive(simulation, options.input, step);
+            simulation.step(SIMULATION_STEP);
+            result->steps++;
+            if (simulation.gameMode() != GAME_SEARCHING) {
+                result->reachedGoal = true;
+                break;
+            }
+        }
+    }
+
+private:
+    const HeadlessOptions &options;
+    int session;
+    SessionResult* result;
+};
+
+// FNV-1a over the bits of every pose, so two replays either match exactly
+// or they don't
+static quint64 hashPose(quint64 hash, const PlayerPose &pose)
+{
+    const float values[3] = { pose.x, pose.y, pose.angle };
+    const uchar* bytes = (const uchar*)values;
+    for (unsigned i = 0; i < sizeof(values); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    return hash;
+}
+
+const quint64 WARMUP_STEPS = 120; // steps allowed to allocate before the count starts
+
+// The first person view of the software renderer, written as images, for
+// play-testing and thumbnails on machines without a GPU. Nothing here or in
+// the renderer makes a window or a GL context.
+class ViewWriter
+{
+public:
+    explicit ViewWriter(const HeadlessOptions &options) :
+        options(options), image(options.renderSize, QImage::Format_RGB32) {}
+
+    bool enabled() const { return !options.render.isEmpty(); }
+
+    // after every step, writes the numbered views --render-every asks for
+    bool stepped(const Maze &maze, const Simulation &simulation, quint64 steps)
+    {
+        if (!enabled() || options.renderEvery == 0 || steps % options.renderEvery != 0)
+            return true;
+        const QFileInfo info(options.render);
+        const QString path = info.path() + "/" + info.completeBaseName() +
+                QString("-%1.").arg(steps, 6, 10, QChar('0')) + info.suffix();
+        return write(maze, simulation, path);
+    }
+
+    // the view at the end
+    bool finished(const Maze &maze, const Simulation &simulation)
+    {
+        return !enabled() || write(maze, simulation, options.render);
+    }
+
+private:
+    // with the goal or exit post, like the window's software view
+    bool write(const Maze &maze, const Simulation &simulation, const QString &path)
+    {
+        markers.resize(0);
+        const int mode = simulation.gameMode();
+        if (mode == GAME_SEARCHING || mode == GAME_FLEEING) {
+            const QPoint cell = mode == GAME_SEARCHING ? simulation.goal() : simulation.start();
+            RenderMarker marker;
+            marker.position = QPointF(CELL_WIDTH * cell.x() + 0.5f*CELL_WIDTH, CELL_WIDTH * cell.y() + 0.5f*CELL_WIDTH);
+            marker.color = mode == GAME_SEARCHING ? qRgb(0, 0, 255) : qRgb(255, 255, 255);
+            markers.append(marker);
+        }
+
+        renderer.render(image, maze, simulation.pose(), simulation.upDownAngle(), markers);
+        if (!image.save(path)) {
+            std::cerr << "can't write image " << path.toStdString() << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    const HeadlessOptions &options;
+    SoftwareRenderer renderer;
+    QImage image;
+    QVector<RenderMarker> markers;
+};
+
+// One recorded session again, step for step and as fast as it goes. The
+// same build gives the same trajectory hash every time. Builds with the
+// allocation counter also tell what the steps past the warm-up allocated.
+static int replay(const HeadlessOptions &options)
+{
+    QScopedPointer<InputLog> log(InputLog::load(options.replay));
+    if (!log)
+        return 1;
+    const InputLogHeader &header = log->header();
+
+    QScopedPointer<Maze> maze;
+    MazeExtras extras;
+    if (options.mazeFile.isEmpty())
+        maze.reset(new Maze(header.width, header.height, header.seed));
+    else
+        maze.reset(Maze::load(options.mazeFile, &extras));
+    if (!maze)
+        return 1;
+    if (!log->matches(*maze)) {
+        std::cerr << "the log was recorded in a different maze, pass the one it was played in with --maze" << std::endl;
+        return 1;
+    }
+
+    if (!options.profileTrace.isEmpty()) {
+        Profiler::setEnabled(true);
+        Profiler::setThreadName("replay");
+    }
+
+    // the file's saved distances only if they are from the log's start
+    const QPoint start(header.startX, header.startY);
+    const quint32* distances = extras.hasEndpoints && extras.start == start ? extras.distances : 0;
+    Simulation simulation(*maze, log->physics(), start, QPoint(header.goalX, header.goalY), distances);
+    ViewWriter views(options);
+
+    const QVector<InputFrame> &frames = log->frames();
+    const float step = (float)header.step;
+    int next = 0;
+    int keys = 0;
+    quint64 hash = 1469598103934665603ULL;
+    qint64 slowest = 0;
+    AllocationCount allocated = { 0, 0 };
+    quint64 allocatingSteps = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (quint64 tick = 0; tick < log->steps(); tick++) {
+        QPoint mouse(0, 0);
+        if (next < frames.size() && frames[next].tick == tick) {
+            keys = frames[next].keys;
+            mouse = frames[next].mouse;
+            next++;
+        }
+        simulation.setInput(keys, mouse);
+
+        const qint64 before = timer.nsecsElapsed();
+        const AllocationCount allocatedBefore = AllocationCounter::thread();
+        simulation.step(step);
+        const AllocationCount allocatedAfter = AllocationCounter::thread();
+        slowest = std::max(slowest, timer.nsecsElapsed() - before);
+        if (tick >= WARMUP_STEPS && allocatedAfter.allocations != allocatedBefore.allocations) {
+            allocated.allocations += allocatedAfter.allocations - allocatedBefore.allocations;
+            allocated.bytes += allocatedAfter.bytes - allocatedBefore.bytes;
+            allocatingSteps++;
+        }
+
+        if (!views.stepped(*maze, simulation, tick + 1))
+            return 1;
+
+        const PlayerPose pose = simulation.pose();
+        hash = hashPose(hash, pose);
+        if (options.trace > 0 && tick % options.trace == 0)
+            std::cout << "tick " << tick << " pose " << pose.x << "," << pose.y << " angle " << pose.angle
+                      << " mode " << simulation.gameMode() << std::endl;
+    }
+    const double seconds = timer.nsecsElapsed() * 1e-9;
+
+    const PlayerPose pose = simulation.pose();
+    const double steps = std::max((quint64)1, log->steps());
+    std::cout << "replayed " << log->steps() << " steps of a " << header.width << "x" << header.height << " maze, "
+              << log->physics().toStdString() << " physics, " << frames.size() << " input records" << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << "wall time      " << seconds << " s" << std::endl
+              << "steps/s        " << std::setprecision(0) << steps / seconds << std::endl
+              << "sim speed      " << std::setprecision(1) << steps * step / seconds << "x real time" << std::endl
+              << "step mean      " << std::setprecision(2) << seconds * 1e6 / steps << " us" << std::endl
+              << "step max       " << slowest * 1e-3 << " us" << std::endl
+              << "final pose     " << std::setprecision(4) << pose.x << "," << pose.y << " angle " << pose.angle
+              << ", mode " << simulation.gameMode() << std::endl
+              << "trajectory     " << std::hex << hash << std::dec << std::endl;
+    if (AllocationCounter::available())
+        std::cout << "allocations    " << allocated.allocations << " (" << allocated.bytes << " bytes) in "
+                  << allocatingSteps << " of the steps after the first " << WARMUP_STEPS << std::endl;
+
+    if (!views.finished(*maze, simulation))
+        return 1;
+    if (!options.profileTrace.isEmpty() && !Profiler::writeChromeTrace(options.profileTrace))
+        return 1;
+    return 0;
+}
+
+// the first of the sessions alone, on this thread, with its views written
+static int renderSession(const HeadlessOptions &options)
+{
+    Maze maze(options.size, options.size, DEFAULT_MAZE_SEED);
+    Simulation simulation(maze, options.physics);
+    Driver driver(DEFAULT_MAZE_SEED);
+    ViewWriter views(options);
+
+    int steps = 0;
+    while (steps < options.steps && simulation.gameMode() == GAME_SEARCHING) {
+        driver.drive(simulation, options.input, steps);
+        simulation.step(SIMULATION_STEP);
+        steps++;
+        if (!views.stepped(maze, simulation, steps))
+            return 1;
+    }
+    if (!views.finished(maze, simulation))
+        return 1;
+
+    const PlayerPose pose = simulation.pose();
+    std::cout << "played " << steps << " steps of a " << options.size << "x" << options.size << " maze, "
+              << options.physics.toStdString() << " physics, " << options.input.toStdString() << " input" << std::endl
+              << "final pose " << pose.x << "," << pose.y << " angle " << pose.angle
+              << ", mode " << simulation.gameMode() << std::endl
+              << "view written to " << options.render.toStdString() << std::endl;
+    return 0;
+}
+
+static HeadlessOptions parse(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs many game sessions without a window, as fast as they go.");
+    parser.addHelpOption();
+    QCommandLineOption sessionsOption("sessions", "Independent sessions to run.", "N", "1000");
+    parser.addOption(sessionsOption);
+    QCommandLineOption stepsOption("steps", "Most steps per session.", "N", "12000");
+    parser.addOption(stepsOption);
+    QCommandLineOption sizeOption("size", "Cells per side of each maze.", "N", "20");
+    parser.addOption(sizeOption);
+    QCommandLineOption physicsOption("physics", "Physics backend: box2d or grid.", "backend", "box2d");
+    parser.addOption(physicsOption);
+    QCommandLineOption inputOption("input", "Scripted player: seek (follows the hints) or wander.", "input", "seek");
+    parser.addOption(inputOption);
+    QCommandLineOption threadsOption("threads", "Worker threads, 0 for one per core.", "N", "0");
+    parser.addOption(threadsOption);
+    QCommandLineOption replayOption("replay", "Replay an input log recorded with maze --record instead.", "log");
+    parser.addOption(replayOption);
+    QCommandLineOption mazeOption("maze", "The maze file the replayed log was played in.", "file");
+    parser.addOption(mazeOption);
+    QCommandLineOption traceOption("trace", "Print the replayed pose every N steps.", "N", "0");
+    parser.addOption(traceOption);
+    QCommandLineOption profileTraceOption("profile-trace", "Write the replay's last profiled zones as a Chrome trace.", "file");
+    parser.addOption(profileTraceOption);
+    QCommandLineOption renderOption("render", "Play one session, or the replay, and write its last view as an image, "
+                                    "drawn by the software renderer without any GL.", "png");
+    parser.addOption(renderOption);
+    QCommandLineOption renderSizeOption("render-size", "Pixels of the rendered views.", "WxH", "640x360");
+    parser.addOption(renderSizeOption);
+    QCommandLineOption renderEveryOption("render-every", "Also write a numbered view every N steps.", "N", "0");
+    parser.addOption(renderEveryOption);
+    parser.process(arguments);
+
+    HeadlessOptions options;
+    options.sessions = std::max(1, parser.value(sessionsOption).toInt());
+    options.steps = std::max(1, parser.value(stepsOption).toInt());
+    options.size = std::max(2, parser.value(sizeOption).toInt());
+    options.physics = parser.value(physicsOption);
+    if (options.physics != "box2d" && options.physics != "grid") {
+        std::cerr << "unknown physics backend, using box2d" << std::endl;
+        options.physics = "box2d";
+    }
+    options.input = parser.value(inputOption);
+    if (options.input != "seek" && options.input != "wander") {
+        std::cerr << "unknown input, using seek" << std::endl;
+        options.input = "seek";
+    }
+    options.replay = parser.value(replayOption);
+    options.mazeFile = parser.value(mazeOption);
+    options.trace = std::max(0, parser.value(traceOption).toInt());
+    options.profileTrace = parser.value(profileTraceOption);
+    options.render = parser.value(renderOption);
+    const QStringList size = parser.value(renderSizeOption).split('x');
+    options.renderSize = QSize(640, 360);
+    if (size.size() == 2 && size[0].toInt() > 0 && size[1].toInt() > 0)
+        options.renderSize = QSize(size[0].toInt(), size[1].toInt());
+    else
+        std::cerr << "render size isn't WxH, using 640x360" << std::endl;
+    options.renderEvery = std::max(0, parser.value(renderEveryOption).toInt());
+
+    const int threads = parser.value(threadsOption).toInt();
+    if (threads > 0)
+        QThreadPool::globalInstance()->setMaxThreadCount(threads);
+    return options;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const HeadlessOptions options = parse(app.arguments());
+    if (!options.replay.isEmpty())
+        return replay(options);
+    if (!options.render.isEmpty())
+        return renderSession(options);
+
+    QVector<SessionResult> results(options.sessions);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < options.sessions; i++)
+        QThreadPool::globalInstance()->start(new SessionJob(options, i, &results[i]));
+    QThreadPool::globalInstance()->waitForDone();
+    const double seconds = timer.nsecsElapsed() * 1e-9;
+
+    qint64 steps = 0;
+    qint64 goalSteps = 0;
+    int reached = 0;
+    for (int i = 0; i < results.size(); i++) {
+        steps += results[i].steps;
+        if (results[i].reachedGoal) {
+            reached++;
+            goalSteps += results[i].steps;
+        }
+    }
+
+    const double simulated = steps * SIMULATION_STEP;
+    std::cout << options.sessions << " sessions of a " << options.size << "x" << options.size << " maze, "
+              << options.physics.toStdString() << " physics, " << options.input.toStdString() << " input, "
+              << QThreadPool::globalInstance()->maxThreadCount() << " threads" << std::endl;
+    std::cout << std::fixed << std::setprecision(2)
+              << "wall time      " << seconds << " s" << std::endl
+              << "steps          " << steps << std::endl
+              << "steps/s        " << std::setprecision(0) << steps / seconds << std::endl
+              << "sim speed      " << std::setprecision(1) << simulated / seconds << "x real time" << std::endl
+              << "reached goal   " << reached << " of " << options.sessions;
+    if (reached > 0)
+        std::cout << ", " << std::setprecision(1) << goalSteps * SIMULATION_STEP / reached << " s on average";
+    std::cout << std::endl;
+
+    return 0;
+}
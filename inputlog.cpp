@@ -0,0 +1,191 @@
+#include "inputlog.h"
+
+#include <iostream>
+#include <string.h>
+
+static const int FLUSH_BYTES = 64 * 1024;
+
+static void appendVarint(QByteArray &buffer, quint64 value)
+{
+    while (value >= 0x80) {
+        buffer.append((char)(value | 0x80));
+        value >>= 7;
+    }
+    buffer.append((char)value);
+}
+
+// small of either sign stays small
+static quint64 zigzag(qint64 value)
+{
+    return ((quint64)value << 1) ^ (quint64)(value >> 63);
+}
+
+static qint64 unzigzag(quint64 value)
+{
+    return (qint64)(value >> 1) ^ -(qint64)(value & 1);
+}
+
+// false if the buffer ends inside the number or it's too long to be one
+static bool readVarint(const uchar* &data, const uchar* end, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data == end)
+            return false;
+        const uchar byte = *data++;
+        value |= (quint64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+InputRecorder::InputRecorder(const QString &path, const Maze &maze, const QString &physics, QPoint start, QPoint goal,
+                             double step) :
+    _file(path), _lastTick(0), _nextTick(0), _keys(0)
+{
+    memset(&_header, 0, sizeof(_header));
+    memcpy(_header.magic, INPUT_LOG_MAGIC, sizeof(_header.magic));
+    _header.version = INPUT_LOG_VERSION;
+    _header.byteOrder = INPUT_LOG_BYTE_ORDER;
+    _header.headerSize = sizeof(InputLogHeader);
+    _header.physics = physics == "grid" ? INPUT_LOG_GRID : INPUT_LOG_BOX2D;
+    _header.width = maze.width();
+    _header.height = maze.height();
+    _header.seed = maze.seed();
+    _header.startX = start.x();
+    _header.startY = start.y();
+    _header.goalX = goal.x();
+    _header.goalY = goal.y();
+    _header.wallHash = maze.wallHash();
+    _header.step = step;
+
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cerr << "can't write input log " << path.toStdString() << std::endl;
+        return;
+    }
+    if (_file.write((const char*)&_header, sizeof(_header)) != sizeof(_header)) {
+        std::cerr << "failed writing input log " << path.toStdString() << std::endl;
+        _file.close();
+        return;
+    }
+    _buffer.reserve(FLUSH_BYTES + 64);
+}
+
+InputRecorder::~InputRecorder()
+{
+    if (!_file.isOpen())
+        return;
+
+    append(_nextTick, INPUT_LOG_END, QPoint(0, 0));
+    flush();
+    _header.steps = _nextTick;
+    if (!_file.seek(0) || _file.write((const char*)&_header, sizeof(_header)) != sizeof(_header))
+        std::cerr << "failed finishing input log " << _file.fileName().toStdString() << std::endl;
+}
+
+void InputRecorder::record(quint64 tick, int keys, QPoint mouse)
+{
+    if (!_file.isOpen())
+        return;
+
+    if (keys != _keys || !mouse.isNull()) {
+        append(tick, keys, mouse);
+        _keys = keys;
+    }
+    _nextTick = tick + 1;
+
+    if (_buffer.size() >= FLUSH_BYTES)
+        flush();
+}
+
+void InputRecorder::append(quint64 tick, int keys, QPoint mouse)
+{
+    appendVarint(_buffer, tick - _lastTick);
+    _buffer.append((char)keys);
+    appendVarint(_buffer, zigzag(mouse.x()));
+    appendVarint(_buffer, zigzag(mouse.y()));
+    _lastTick = tick;
+}
+
+void InputRecorder::flush()
+{
+    if (_buffer.isEmpty())
+        return;
+    if (_file.write(_buffer) != _buffer.size()) {
+        std::cerr << "failed writing input log " << _file.fileName().toStdString() << std::endl;
+        _file.close();
+    }
+    _buffer.resize(0); // keeps what was reserved, unlike clear()
+}
+
+InputLog* InputLog::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cerr << "can't open input log " << path.toStdString() << std::endl;
+        return 0;
+    }
+    const QByteArray bytes = file.readAll();
+    if ((quint64)bytes.size() < sizeof(InputLogHeader)) {
+        std::cerr << "not an input log" << std::endl;
+        return 0;
+    }
+
+    InputLog* log = new InputLog();
+    InputLogHeader &header = log->_header;
+    memcpy(&header, bytes.constData(), sizeof(header));
+    if (memcmp(header.magic, INPUT_LOG_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "not an input log" << std::endl;
+        delete log;
+        return 0;
+    }
+    if (header.byteOrder != INPUT_LOG_BYTE_ORDER) {
+        std::cerr << "input log has the wrong byte order" << std::endl;
+        delete log;
+        return 0;
+    }
+    if (header.version != INPUT_LOG_VERSION || header.headerSize != sizeof(InputLogHeader)) {
+        std::cerr << "unsupported input log version " << header.version << std::endl;
+        delete log;
+        return 0;
+    }
+
+    const uchar* data = (const uchar*)bytes.constData() + sizeof(InputLogHeader);
+    const uchar* end = (const uchar*)bytes.constData() + bytes.size();
+    quint64 tick = 0;
+    bool closed = false;
+    while (data != end) {
+        quint64 delta, dx, dy;
+        if (!readVarint(data, end, delta) || data == end)
+            break;
+        const int keys = *data++;
+        if (!readVarint(data, end, dx) || !readVarint(data, end, dy))
+            break;
+
+        tick += delta;
+        if (keys & INPUT_LOG_END) {
+            log->_steps = tick;
+            closed = true;
+            break;
+        }
+        InputFrame frame;
+        frame.tick = tick;
+        frame.keys = keys;
+        frame.mouse = QPoint(unzigzag(dx), unzigzag(dy));
+        log->_frames.append(frame);
+    }
+
+    // whatever got written before the recorder went away
+    if (!closed) {
+        std::cerr << "input log is truncated, replaying up to its last record" << std::endl;
+        log->_steps = log->_frames.isEmpty() ? 0 : log->_frames.last().tick + 1;
+    }
+    return log;
+}
+
+bool InputLog::matches(const Maze &maze) const
+{
+    return (quint32)maze.width() == _header.width && (quint32)maze.height() == _header.height &&
+            maze.wallHash() == _header.wallHash;
+}
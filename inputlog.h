@@ -0,0 +1,103 @@
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include "maze.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QPoint>
+#include <QString>
+#include <QVector>
+
+// A recorded session: InputLogHeader, then one record for every step whose
+// input differs from "same keys as before, mouse still", native byte order:
+//
+//   varint  steps since the previous record
+//   byte    KEY_* bits held, INPUT_LOG_END on the closing record
+//   varint  zigzag mouse dx
+//   varint  zigzag mouse dy
+//
+// The header is written again on close with the step count; a log cut short
+// by a crash still replays up to its last record.
+
+const char INPUT_LOG_MAGIC[8] = { 'M', 'A', 'Z', 'E', 'I', 'N', 'P', 'T' };
+const quint32 INPUT_LOG_VERSION = 1;
+const quint32 INPUT_LOG_BYTE_ORDER = 0x01020304;
+const int INPUT_LOG_END = 0x80;
+
+enum { INPUT_LOG_BOX2D, INPUT_LOG_GRID };
+
+struct InputLogHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 headerSize;
+    quint32 physics; // INPUT_LOG_*
+    quint32 width;
+    quint32 height;
+    quint32 seed;
+    qint32 startX, startY;
+    qint32 goalX, goalY;
+    quint32 reserved;
+    quint64 wallHash; // Maze::wallHash(), to tell a different maze
+    double step; // seconds per step
+    quint64 steps; // 0 until the log is closed
+};
+
+// what one step saw
+struct InputFrame
+{
+    quint64 tick;
+    int keys; // KEY_*
+    QPoint mouse;
+};
+
+// Appends the input of every Simulation step to a log, buffered and written
+// out in blocks, so recording costs next to nothing per step.
+class InputRecorder
+{
+public:
+    InputRecorder(const QString &path, const Maze &maze, const QString &physics, QPoint start, QPoint goal, double step);
+    ~InputRecorder();
+
+    bool isOpen() const { return _file.isOpen(); }
+
+    // before the step with this tick runs
+    void record(quint64 tick, int keys, QPoint mouse);
+
+private:
+    void append(quint64 tick, int keys, QPoint mouse);
+    void flush();
+
+    QFile _file;
+    InputLogHeader _header;
+    QByteArray _buffer;
+    quint64 _lastTick; // of the last record
+    quint64 _nextTick; // one past the last step seen
+    int _keys;
+};
+
+class InputLog
+{
+public:
+    // null if the file isn't a complete enough log
+    static InputLog* load(const QString &path);
+
+    const InputLogHeader& header() const { return _header; }
+    QString physics() const { return _header.physics == INPUT_LOG_GRID ? "grid" : "box2d"; }
+    quint64 steps() const { return _steps; }
+    const QVector<InputFrame>& frames() const { return _frames; }
+
+    // the maze the session was played in, if this one is it
+    bool matches(const Maze &maze) const;
+
+private:
+    InputLog() : _steps(0) {}
+
+    InputLogHeader _header;
+    quint64 _steps;
+    QVector<InputFrame> _frames;
+};
+
+#endif // INPUTLOG_H
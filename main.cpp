@@ -1,10 +1,12 @@
 #include "mainwindow.h"
+#include "options.h"
 #include <QApplication>
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
-    MainWindow w;
+    MazeOptions options = MazeOptions::parse(a.arguments());
+    MainWindow w(options);
     w.show();
 
     return a.exec();
@@ -4,7 +4,7 @@
 
 #include <QTimer>
 
-MainWindow::MainWindow(QWidget *parent) :
+MainWindow::MainWindow(const MazeOptions &options, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
@@ -13,7 +13,7 @@ MainWindow::MainWindow(QWidget *parent) :
     //QGLFormat format;
     //format.setDepth(true);
 
-    MazeView* mazeView = new MazeView();
+    MazeView* mazeView = new MazeView(options);
 
     QGLFormat format;
     format.setDepthBufferSize(24);
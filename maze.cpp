@@ -1,107 +1,243 @@
 #include "maze.h"
 
-#include <QSet>
+#include "random.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
 #include <algorithm>
 
-#include <iostream>
+// chance of carrying on one more cell in a straight line after knocking down
+// a wall; the original generator's loop only ever retried that one cell
+const float CORRIDOR_BIAS = 0.99f;
 
-inline std::string toString(QPoint p) {
-    return QString("(%1, %2)").arg(p.x()).arg(p.y()).toStdString();
+Maze::Maze(const int width, const int height, const quint32 seed) : _walls(width, height), WIDTH(width), HEIGHT(height), SEED(seed)
+{
+    generate(QRect(0, 0, width, height), seed);
 }
 
-inline uint qHash(const QPoint p) {
-    return qHash(QString::fromStdString(toString(p)), 0xa03f); // arbitrary value
+Maze::Maze(const int width, const int height, const quint32 seed, const int threads) : _walls(width, height), WIDTH(width), HEIGHT(height), SEED(seed)
+{
+    generateTiled(threads);
 }
 
-inline float randomFloat() {
-    return ((float) rand()) / (float) RAND_MAX;
+Maze::Maze(const WallGrid &walls, quint32 seed, QSharedPointer<QFile> file) :
+    _walls(walls),
+    _file(file),
+    WIDTH(walls.width()),
+    HEIGHT(walls.height()),
+    SEED(seed)
+{
 }
 
-QPoint randomInSet(QSet<QPoint> points)
+inline bool isVisited(const QVector<quint64> &visited, int index)
 {
-    //QSet<QPoint>::iterator i = points.begin();
-
-    int index = points.size() * randomFloat();
+    return visited[index >> 6] & (1ULL << (index & 63));
+}
 
-    int i = 0;
-    foreach (QPoint p, points) {
-        if (i == index)
-            return p;
-        i++;
-    }
+inline void visit(QVector<quint64> &visited, int index)
+{
+    visited[index >> 6] |= 1ULL << (index & 63);
 }
 
-Maze::Maze(const int width, const int height) : WIDTH(width), HEIGHT(height)
+// randomized growing tree over packed cell indices (y*width + x) of one
+// rectangle of cells, never opening its border; every step is O(1) so
+// generation time is linear in the number of cells
+void Maze::generate(QRect cells, quint64 seed)
 {
+    const int width = cells.width();
+    const int height = cells.height();
     const int TOTAL_CELLS = width * height;
+    if (TOTAL_CELLS <= 0)
+        return;
 
-    _horizontals = QVector<bool>(width * (height+1));
-    _verticals = QVector<bool>((width+1) * height);
+    Random random(seed);
+    const QPoint origin = cells.topLeft();
 
-    _horizontals.fill(true);
-    _verticals.fill(true);
+    // one bit per cell
+    QVector<quint64> visited((TOTAL_CELLS + 63) / 64, 0);
 
-    QSet<QPoint> visited;
-    visited.insert(QPoint(0,0));
+    // visited cells that may still have unvisited neighbours, removed by
+    // swapping in the last entry once they turn out to be dead ends
+    QVector<int> frontier;
+    frontier.reserve(TOTAL_CELLS);
 
-    // grab unvisited point next to visited point
-    while (visited.size() < TOTAL_CELLS) {
-        QPoint randomVisited = randomInSet(visited);
+    visit(visited, 0);
+    frontier.append(0);
+
+    while (!frontier.isEmpty()) {
+        const int slot = random.below(frontier.size());
+        const int current = frontier[slot];
+        const int x = current % width;
+        const int y = current / width;
 
         // figure out possible directions
-        QPoint left(randomVisited.x()-1, randomVisited.y());
-        QPoint right(randomVisited.x()+1, randomVisited.y());
-        QPoint up(randomVisited.x(), randomVisited.y()+1);
-        QPoint down(randomVisited.x(), randomVisited.y()-1);
-
-        QSet<QPoint> possibleNexts;
-        if (left.x() >= 0 && !visited.contains(left))
-            possibleNexts.insert(left);
-        else if (right.x() < width && !visited.contains(right))
-            possibleNexts.insert(right);
-        else if (up.y() < height && !visited.contains(up))
-            possibleNexts.insert(up);
-        else if (down.y() >= 0 && !visited.contains(down))
-            possibleNexts.insert(down);
-
-        if (possibleNexts.size() > 0) {
-            QPoint next = randomInSet(possibleNexts);
-
-            // knock down walls between to points
-            removeWall(next, randomVisited);
-            visited.insert(next);
-
-            // see if you can step in that direction again
-            QPoint prev = randomVisited;
-            QPoint step = next;
-            int x = next.x() - randomVisited.x();
-            int y = next.y() - randomVisited.y();
-            while (randomFloat() < 0.99f) {
-                QPoint tmpPrev = step;
-                step = QPoint(next.x() + x, next.y() + y);
-                if (!visited.contains(step) && step.x() >= 0 && step.x() < width && step.y() >= 0 && step.y() < height) {
-                    removeWall(step, tmpPrev);
-                    visited.insert(step);
-                }
-                prev = tmpPrev;
+        int nexts[4];
+        int count = 0;
+        if (x > 0 && !isVisited(visited, current - 1))
+            nexts[count++] = current - 1;
+        if (x < width - 1 && !isVisited(visited, current + 1))
+            nexts[count++] = current + 1;
+        if (y < height - 1 && !isVisited(visited, current + width))
+            nexts[count++] = current + width;
+        if (y > 0 && !isVisited(visited, current - width))
+            nexts[count++] = current - width;
+
+        if (count == 0) {
+            frontier[slot] = frontier.last();
+            frontier.removeLast();
+            continue;
+        }
+
+        int next = nexts[random.below(count)];
+        const int dx = next % width - x;
+        const int dy = next / width - y;
+
+        // knock down walls between to points
+        setWall(origin + QPoint(next % width, next / width), origin + QPoint(x, y), false);
+        visit(visited, next);
+        frontier.append(next);
+
+        // see if you can step in that direction again
+        if (random.uniform() < CORRIDOR_BIAS) {
+            const int stepX = next % width + dx;
+            const int stepY = next / width + dy;
+            const int step = stepY * width + stepX;
+            if (stepX >= 0 && stepX < width && stepY >= 0 && stepY < height && !isVisited(visited, step)) {
+                setWall(origin + QPoint(stepX, stepY), origin + QPoint(next % width, next / width), false);
+                visit(visited, step);
+                frontier.append(step);
             }
         }
     }
 }
 
-void Maze::removeWall(QPoint a, QPoint b)
+// one tile's spanning tree, run on the pool
+class MazeTileJob : public QRunnable
+{
+public:
+    MazeTileJob(Maze* maze, QRect cells, quint64 seed) : maze(maze), cells(cells), seed(seed) {}
+
+    void run() { maze->generate(cells, seed); }
+
+private:
+    Maze* maze;
+    QRect cells;
+    quint64 seed;
+};
+
+// where tile i starts along an axis; the first column tile is one short so
+// the rest start at 64k-1 and their inner walls never share a word
+static int tileStart(int i, int tile, int shift)
+{
+    return i == 0 ? 0 : i * tile - shift;
+}
+
+static int find(QVector<int> &parent, int i)
+{
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Every tile gets a spanning tree of its own, all at once since they only
+// write the words inside their own rectangle. Then a randomized Kruskal pass
+// over the tile grid opens exactly one wall in the shared border of each
+// pair it joins, which keeps the whole maze a single tree.
+void Maze::generateTiled(int threads)
+{
+    if (WIDTH <= 0 || HEIGHT <= 0)
+        return;
+
+    const int columns = (WIDTH + 1 + MAZE_TILE_COLUMNS - 1) / MAZE_TILE_COLUMNS;
+    const int rows = (HEIGHT + MAZE_TILE_ROWS - 1) / MAZE_TILE_ROWS;
+    QVector<QRect> tiles;
+    for (int ty = 0; ty < rows; ty++) {
+        for (int tx = 0; tx < columns; tx++) {
+            const int left = tileStart(tx, MAZE_TILE_COLUMNS, 1);
+            const int right = std::min(WIDTH, tileStart(tx + 1, MAZE_TILE_COLUMNS, 1));
+            const int top = tileStart(ty, MAZE_TILE_ROWS, 0);
+            const int bottom = std::min(HEIGHT, tileStart(ty + 1, MAZE_TILE_ROWS, 0));
+            tiles.append(QRect(left, top, right - left, bottom - top));
+        }
+    }
+
+    // tile seeds only depend on the maze seed and the tile
+    Random seeds(SEED);
+    QVector<quint64> tileSeeds(tiles.size());
+    for (int i = 0; i < tiles.size(); i++)
+        tileSeeds[i] = ((quint64)seeds.next() << 32) | seeds.next();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+    for (int i = 0; i < tiles.size(); i++)
+        pool.start(new MazeTileJob(this, tiles[i], tileSeeds[i]));
+    pool.waitForDone();
+
+    // every pair of neighbouring tiles, east then north, in random order
+    QVector<QPoint> borders; // (tile, neighbour)
+    for (int ty = 0; ty < rows; ty++) {
+        for (int tx = 0; tx < columns; tx++) {
+            const int tile = ty * columns + tx;
+            if (tx + 1 < columns)
+                borders.append(QPoint(tile, tile + 1));
+            if (ty + 1 < rows)
+                borders.append(QPoint(tile, tile + columns));
+        }
+    }
+    Random random(seeds.next());
+    for (int i = borders.size() - 1; i > 0; i--)
+        std::swap(borders[i], borders[random.below(i + 1)]);
+
+    QVector<int> parent(tiles.size());
+    for (int i = 0; i < parent.size(); i++)
+        parent[i] = i;
+
+    for (int i = 0; i < borders.size(); i++) {
+        const int a = find(parent, borders[i].x());
+        const int b = find(parent, borders[i].y());
+        if (a == b)
+            continue;
+        parent[b] = a;
+
+        const QRect &from = tiles[borders[i].x()];
+        const QRect &to = tiles[borders[i].y()];
+        if (to.top() == from.top()) { // east
+            const int y = from.top() + random.below(from.height());
+            setWall(QPoint(to.left() - 1, y), QPoint(to.left(), y), false);
+        } else { // north
+            const int x = from.left() + random.below(from.width());
+            setWall(QPoint(x, to.top() - 1), QPoint(x, to.top()), false);
+        }
+    }
+}
+
+void Maze::setWall(QPoint a, QPoint b, bool wall)
 {
     if (a.x() - b.x() != 0) { // horizontally adjacent
         const int x = std::min(a.x(), b.x());
-        _verticals[a.y()*(WIDTH+1) + x+1] = false;
+        _walls.setVertical(x+1, a.y(), wall);
     } else { // vertically adjacent
         const int y = std::min(a.y(), b.y());
-        _horizontals[y+1 + a.x()*(HEIGHT+1)] = false;
+        _walls.setHorizontal(a.x(), y+1, wall);
     }
 }
 
+quint64 Maze::wallHash() const
+{
+    quint64 hash = 1469598103934665603ULL;
+    for (int i = 0; i < _walls.horizontalWords(); i++)
+        hash = (hash ^ _walls.horizontals()[i]) * 1099511628211ULL;
+    for (int i = 0; i < _walls.verticalWords(); i++)
+        hash = (hash ^ _walls.verticals()[i]) * 1099511628211ULL;
+    return hash;
+}
+
 // returns a dummy cell with all walls if out of bounds
-Cell Maze::cell(int x, int y)
+Cell Maze::cell(int x, int y) const
 {
     Cell cell;
 
@@ -111,10 +247,11 @@ Cell Maze::cell(int x, int y)
         cell.up = true;
         cell.down = true;
     } else {
-        cell.left = _verticals[y*(WIDTH+1) + x];
-        cell.right = _verticals[y*(WIDTH+1) + x+1];
-        cell.up = _horizontals[y+1 + x*(HEIGHT+1)];
-        cell.down = _horizontals[y + x*(HEIGHT+1)];
+        const WallRow r = _walls.row(y);
+        cell.left = r.left(x);
+        cell.right = r.right(x);
+        cell.up = r.up(x);
+        cell.down = r.down(x);
     }
 
     return cell;
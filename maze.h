@@ -1,29 +1,90 @@
 #ifndef MAZE_H
 #define MAZE_H
 
+#include "wallgrid.h"
+
 #include <QVector>
 #include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QSharedPointer>
+
+class QFile;
 
 struct Cell
 {
     bool up, down, left, right;
 };
 
+// what a maze file can carry besides the walls
+struct MazeExtras
+{
+    MazeExtras() : hasEndpoints(false), distances(0) {}
+
+    bool hasEndpoints;
+    QPoint start;
+    QPoint goal;
+
+    // width * height steps from start, row-major, or null; after load() it
+    // points into the mapped file and lives as long as the maze
+    const quint32* distances;
+};
+
+const quint32 DEFAULT_MAZE_SEED = 0x6d617a65;
+
+// cells per tile of a parallel generated maze; tiles start one column before
+// every multiple of 64 so each owns whole words of the wall rows
+const int MAZE_TILE_COLUMNS = 256;
+const int MAZE_TILE_ROWS = 256;
+
+// world units per cell
+const float CELL_WIDTH = 2.0f;
+const float WALL_HEIGHT = 2.0f * 1.61;
+
 class Maze
 {
 public:
-    Maze(const int width, const int height);
-    Cell cell(int x, int y);
-    int width() { return WIDTH; }
-    int height() { return HEIGHT; }
+    Maze(const int width, const int height, const quint32 seed = DEFAULT_MAZE_SEED);
+
+    // generates tiles concurrently on up to threads threads (0 for one per
+    // core) and joins them into one perfect maze. The result only depends
+    // on the seed, not on the thread count, but differs from the serial one.
+    Maze(const int width, const int height, const quint32 seed, const int threads);
+    Cell cell(int x, int y) const;
+    int width() const { return WIDTH; }
+    int height() const { return HEIGHT; }
+    quint32 seed() const { return SEED; }
+
+    // sequential, bounds-check free access for whole-grid scans
+    const WallGrid& walls() const { return _walls; }
+    WallRow row(int y) const { return _walls.row(y); }
+    WallNeighborhood neighborhood(int y) const { return _walls.neighborhood(y); }
+
+    // FNV-1a over every wall word, equal for equal walls
+    quint64 wallHash() const;
+
+    // the wall between two adjacent cells; either may be just outside the
+    // maze to change its border
+    void setWall(QPoint a, QPoint b, bool wall);
+
+    // versioned binary file, see mazefile.cpp. load() maps the file and reads
+    // the walls in place, so opening costs the same for any size; null if the
+    // file can't be used
+    bool save(const QString &path, const MazeExtras &extras = MazeExtras()) const;
+    static Maze* load(const QString &path, MazeExtras* extras = 0);
 private:
-    QVector<bool> _horizontals;
-    QVector<bool> _verticals;
+    Maze(const WallGrid &walls, quint32 seed, QSharedPointer<QFile> file);
+
+    WallGrid _walls;
+    QSharedPointer<QFile> _file; // keeps loaded walls mapped
 
-    void removeWall(QPoint a, QPoint b);
+    friend class MazeTileJob;
+    void generate(QRect cells, quint64 seed);
+    void generateTiled(int threads);
 
     const int WIDTH;
     const int HEIGHT;
+    const quint32 SEED;
 };
 
 #endif // MAZE_H
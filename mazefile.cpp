@@ -0,0 +1,140 @@
+#include "maze.h"
+#include "mazefile.h"
+
+#include <QFile>
+#include <QSaveFile>
+
+#include <iostream>
+#include <string.h>
+
+static quint64 align8(quint64 offset)
+{
+    return (offset + 7) & ~7ULL;
+}
+
+static bool writePadded(QSaveFile &file, const void* data, quint64 size)
+{
+    static const char ZEROS[8] = { 0 };
+    if (file.write((const char*)data, size) != (qint64)size)
+        return false;
+    const quint64 padding = align8(size) - size;
+    return file.write(ZEROS, padding) == (qint64)padding;
+}
+
+bool Maze::save(const QString &path, const MazeExtras &extras) const
+{
+    MazeFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAZE_FILE_MAGIC, sizeof(header.magic));
+    header.version = MAZE_FILE_VERSION;
+    header.byteOrder = MAZE_FILE_BYTE_ORDER;
+    header.headerSize = sizeof(MazeFileHeader);
+    header.width = WIDTH;
+    header.height = HEIGHT;
+    header.seed = SEED;
+    header.stride = _walls.stride();
+    if (extras.hasEndpoints) {
+        header.flags |= MAZE_FILE_ENDPOINTS;
+        header.startX = extras.start.x();
+        header.startY = extras.start.y();
+        header.goalX = extras.goal.x();
+        header.goalY = extras.goal.y();
+    }
+
+    const quint64 horizontalBytes = (quint64)_walls.horizontalWords() * sizeof(quint64);
+    const quint64 verticalBytes = (quint64)_walls.verticalWords() * sizeof(quint64);
+    const quint64 distanceBytes = extras.distances ? (quint64)WIDTH * HEIGHT * sizeof(quint32) : 0;
+    header.horizontalOffset = align8(sizeof(MazeFileHeader));
+    header.verticalOffset = header.horizontalOffset + horizontalBytes;
+    header.distanceOffset = extras.distances ? header.verticalOffset + verticalBytes : 0;
+    header.fileSize = header.verticalOffset + verticalBytes + align8(distanceBytes);
+
+    // written beside it and renamed over it at the end: the walls and
+    // distances may be mapped from the very file being replaced, and the
+    // old one stays mapped until the maze goes
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        std::cerr << "can't write maze file " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    bool ok = writePadded(file, &header, sizeof(header)) &&
+              writePadded(file, _walls.horizontals(), horizontalBytes) &&
+              writePadded(file, _walls.verticals(), verticalBytes);
+    if (ok && extras.distances)
+        ok = writePadded(file, extras.distances, distanceBytes);
+    ok = ok && file.commit();
+    if (!ok)
+        std::cerr << "failed writing maze file " << path.toStdString() << std::endl;
+    return ok;
+}
+
+// everything a header promises has to be inside the file
+static bool validHeader(const MazeFileHeader &header, quint64 size)
+{
+    if (memcmp(header.magic, MAZE_FILE_MAGIC, sizeof(header.magic)) != 0) {
+        std::cerr << "not a maze file" << std::endl;
+        return false;
+    }
+    if (header.byteOrder != MAZE_FILE_BYTE_ORDER) {
+        std::cerr << "maze file has the wrong byte order" << std::endl;
+        return false;
+    }
+    if (header.version != MAZE_FILE_VERSION || header.headerSize != sizeof(MazeFileHeader)) {
+        std::cerr << "unsupported maze file version " << header.version << std::endl;
+        return false;
+    }
+
+    const quint64 stride = (header.width + 3 + 63) / 64;
+    const quint64 horizontalBytes = (header.height + 3ULL) * stride * sizeof(quint64);
+    const quint64 verticalBytes = (header.height + 2ULL) * stride * sizeof(quint64);
+    const quint64 distanceBytes = (quint64)header.width * header.height * sizeof(quint32);
+    const bool fits = header.stride == stride && header.fileSize <= size &&
+            header.width < (1U << 30) && header.height < (1U << 30) &&
+            header.horizontalOffset % 8 == 0 && header.verticalOffset % 8 == 0 && header.distanceOffset % 8 == 0 &&
+            header.horizontalOffset >= sizeof(MazeFileHeader) && header.horizontalOffset + horizontalBytes <= size &&
+            header.verticalOffset >= sizeof(MazeFileHeader) && header.verticalOffset + verticalBytes <= size &&
+            (header.distanceOffset == 0 || header.distanceOffset + distanceBytes <= size);
+    if (!fits)
+        std::cerr << "maze file is truncated or corrupt" << std::endl;
+    return fits;
+}
+
+Maze* Maze::load(const QString &path, MazeExtras* extras)
+{
+    QSharedPointer<QFile> file(new QFile(path));
+    if (!file->open(QIODevice::ReadOnly)) {
+        std::cerr << "can't open maze file " << path.toStdString() << std::endl;
+        return 0;
+    }
+
+    const quint64 size = file->size();
+    if (size < sizeof(MazeFileHeader)) {
+        std::cerr << "not a maze file" << std::endl;
+        return 0;
+    }
+    const uchar* data = file->map(0, size);
+    if (!data) {
+        std::cerr << "can't map maze file " << path.toStdString() << std::endl;
+        return 0;
+    }
+
+    MazeFileHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (!validHeader(header, size))
+        return 0;
+
+    // the walls stay in the mapping, owned by the maze from here on
+    const WallGrid walls(header.width, header.height,
+                         (const quint64*)(data + header.horizontalOffset),
+                         (const quint64*)(data + header.verticalOffset));
+
+    if (extras) {
+        extras->hasEndpoints = header.flags & MAZE_FILE_ENDPOINTS;
+        extras->start = QPoint(header.startX, header.startY);
+        extras->goal = QPoint(header.goalX, header.goalY);
+        extras->distances = header.distanceOffset ? (const quint32*)(data + header.distanceOffset) : 0;
+    }
+
+    return new Maze(walls, header.seed, file);
+}
@@ -0,0 +1,42 @@
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include <QtGlobal>
+
+// On-disk layout of a saved maze, native byte order. Every section starts on
+// an 8 byte boundary so a mapped file can be read as quint64/quint32 arrays
+// directly:
+//
+//   MazeFileHeader
+//   horizontal wall lines   (height+3) * stride quint64, WallGrid layout
+//   vertical wall rows      (height+2) * stride quint64
+//   distance field          width * height quint32, if distanceOffset != 0
+//
+// Readers refuse any other version.
+
+const char MAZE_FILE_MAGIC[8] = { 'M', 'A', 'Z', 'E', 'B', 'I', 'T', 'S' };
+const quint32 MAZE_FILE_VERSION = 1;
+const quint32 MAZE_FILE_BYTE_ORDER = 0x01020304; // reads back differently on the wrong endianness
+
+enum { MAZE_FILE_ENDPOINTS = 1 };
+
+struct MazeFileHeader
+{
+    char magic[8];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 headerSize;
+    quint32 flags; // MAZE_FILE_*
+    quint32 width;
+    quint32 height;
+    quint32 seed;
+    quint32 stride; // quint64 per wall row
+    qint32 startX, startY;
+    qint32 goalX, goalY;
+    quint64 horizontalOffset; // bytes from the start of the file
+    quint64 verticalOffset;
+    quint64 distanceOffset; // 0 if there is no distance field
+    quint64 fileSize;
+};
+
+#endif // MAZEFILE_H
@@ -0,0 +1,171 @@
+#include "mazephysics.h"
+
+#include <algorithm>
+
+enum { LINK_EAST, LINK_WEST, LINK_NORTH, LINK_SOUTH };
+
+// Joins one tile's wall pieces into polylines. Walls only meet at lattice
+// points, so every point of the tile keeps the piece leaving it in each of
+// the four directions; polylines run between points where walls end or
+// branch, and whatever is left over afterwards are closed loops.
+static void addChains(b2Body* body, const QVector<WallSegment> &pieces, QPoint origin, int tile)
+{
+    const int side = tile + 1;
+    QVector<int> links(side * side * 4, -1);
+    QVector<int> degree(side * side, 0);
+    QVector<bool> used(pieces.size(), false);
+
+    for (int i = 0; i < pieces.size(); i++) {
+        const WallSegment &piece = pieces[i];
+        const int a = (piece.from.y() - origin.y()) * side + piece.from.x() - origin.x();
+        const int b = (piece.to.y() - origin.y()) * side + piece.to.x() - origin.x();
+        if (piece.from.y() == piece.to.y()) {
+            links[a*4 + LINK_EAST] = i;
+            links[b*4 + LINK_WEST] = i;
+        } else {
+            links[a*4 + LINK_NORTH] = i;
+            links[b*4 + LINK_SOUTH] = i;
+        }
+        degree[a]++;
+        degree[b]++;
+    }
+
+    QVector<b2Vec2> vertices;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int point = 0; point < side * side; point++) {
+            // open chains first, then loops from any point still unused
+            if (degree[point] == 0 || (pass == 0 && degree[point] == 2))
+                continue;
+
+            for (int direction = 0; direction < 4; direction++) {
+                int piece = links[point*4 + direction];
+                if (piece < 0 || used[piece])
+                    continue;
+
+                vertices.clear();
+                vertices.append(b2Vec2(CELL_WIDTH * (origin.x() + point % side), CELL_WIDTH * (origin.y() + point / side)));
+
+                int current = point;
+                bool closed = false;
+                while (piece >= 0) {
+                    used[piece] = true;
+                    const WallSegment &p = pieces[piece];
+                    const int a = (p.from.y() - origin.y()) * side + p.from.x() - origin.x();
+                    const int b = (p.to.y() - origin.y()) * side + p.to.x() - origin.x();
+                    current = current == a ? b : a;
+
+                    if (current == point) {
+                        closed = true;
+                        break;
+                    }
+                    vertices.append(b2Vec2(CELL_WIDTH * (origin.x() + current % side), CELL_WIDTH * (origin.y() + current / side)));
+                    if (degree[current] != 2)
+                        break;
+
+                    // carry on through the other wall at this corner
+                    piece = -1;
+                    for (int d = 0; d < 4; d++) {
+                        const int next = links[current*4 + d];
+                        if (next >= 0 && !used[next]) {
+                            piece = next;
+                            break;
+                        }
+                    }
+                }
+
+                b2ChainShape chain;
+                if (closed)
+                    chain.CreateLoop(vertices.constData(), vertices.size());
+                else
+                    chain.CreateChain(vertices.constData(), vertices.size());
+                body->CreateFixture(&chain, 0.0f);
+            }
+        }
+    }
+}
+
+QVector<b2Body*> MazeBodyFactory::chainBodies(b2World* world, const Maze &maze, int tile)
+{
+    return chainBodies(world, WallSegments(maze), QRect(0, 0, maze.width(), maze.height()), tile);
+}
+
+QVector<b2Body*> MazeBodyFactory::chainBodies(b2World* world, const WallSegments &segments, QRect cells, int tile)
+{
+    const int tilesX = (cells.width() + tile - 1) / tile;
+    const int tilesY = (cells.height() + tile - 1) / tile;
+
+    // cut every merged wall where it crosses a tile boundary
+    QVector<QVector<WallSegment> > pieces(tilesX * tilesY);
+    const QVector<WallSegment> &walls = segments.segments();
+    for (int i = 0; i < walls.size(); i++) {
+        const WallSegment &wall = walls[i];
+        const bool horizontal = wall.from.y() == wall.to.y();
+
+        // the line a wall sits on belongs to the tile above or right of it
+        const int line = horizontal ? wall.from.y() - cells.top() : wall.from.x() - cells.left();
+        const int lineTile = std::min(line / tile, (horizontal ? tilesY : tilesX) - 1);
+
+        const int begin = horizontal ? wall.from.x() - cells.left() : wall.from.y() - cells.top();
+        const int end = horizontal ? wall.to.x() - cells.left() : wall.to.y() - cells.top();
+        for (int from = begin; from < end; ) {
+            const int runTile = from / tile;
+            const int to = std::min(end, (runTile + 1) * tile);
+
+            WallSegment piece;
+            if (horizontal) {
+                piece.from = QPoint(cells.left() + from, wall.from.y());
+                piece.to = QPoint(cells.left() + to, wall.from.y());
+                pieces[lineTile * tilesX + runTile].append(piece);
+            } else {
+                piece.from = QPoint(wall.from.x(), cells.top() + from);
+                piece.to = QPoint(wall.from.x(), cells.top() + to);
+                pieces[runTile * tilesX + lineTile].append(piece);
+            }
+            from = to;
+        }
+    }
+
+    QVector<b2Body*> bodies;
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            const QVector<WallSegment> &tilePieces = pieces[ty * tilesX + tx];
+            if (tilePieces.isEmpty())
+                continue;
+
+            b2BodyDef bodyDef;
+            b2Body* body = world->CreateBody(&bodyDef);
+            addChains(body, tilePieces, QPoint(cells.left() + tx * tile, cells.top() + ty * tile), tile);
+            bodies.append(body);
+        }
+    }
+
+    return bodies;
+}
+
+b2Body* MazeBodyFactory::edgeBody(b2World* world, const Maze &maze)
+{
+    b2BodyDef mazeBodyDef;
+    b2Body* mazeBody = world->CreateBody(&mazeBodyDef);
+    for (int row = 0; row < maze.height(); row++) {
+        const WallRow walls = maze.row(row);
+        for (int column = 0; column < maze.width(); column++) {
+            if (walls.up(column)) {
+                b2EdgeShape edge;
+                edge.Set(b2Vec2(CELL_WIDTH * column, CELL_WIDTH * (row+1)), b2Vec2(CELL_WIDTH * (column+1), CELL_WIDTH * (row+1)));
+                mazeBody->CreateFixture(&edge, 0.0f);
+            }
+            if (walls.left(column)) {
+                b2EdgeShape edge;
+                edge.Set(b2Vec2(CELL_WIDTH * column, CELL_WIDTH * row), b2Vec2(CELL_WIDTH * column, CELL_WIDTH * (row+1)));
+                mazeBody->CreateFixture(&edge, 0.0f);
+            }
+        }
+        const int column = maze.width() - 1;
+        if (walls.right(column)) {
+            b2EdgeShape edge;
+            edge.Set(b2Vec2(CELL_WIDTH * (column+1), CELL_WIDTH * row), b2Vec2(CELL_WIDTH * (column+1), CELL_WIDTH * (row+1)));
+            mazeBody->CreateFixture(&edge, 0.0f);
+        }
+    }
+    return mazeBody;
+}
@@ -0,0 +1,28 @@
+#ifndef MAZEPHYSICS_H
+#define MAZEPHYSICS_H
+
+#include "maze.h"
+#include "wallsegments.h"
+
+#include <QVector>
+#include <QRect>
+
+#include <Box2D/Box2D.h>
+
+// cells per side of one static maze body
+const int PHYSICS_TILE = 16;
+
+// Builds the static Box2D geometry for a maze.
+class MazeBodyFactory
+{
+public:
+    // merged walls joined into b2ChainShape polylines, split into one static
+    // body per PHYSICS_TILE x PHYSICS_TILE block of cells
+    static QVector<b2Body*> chainBodies(b2World* world, const Maze &maze, int tile = PHYSICS_TILE);
+    static QVector<b2Body*> chainBodies(b2World* world, const WallSegments &segments, QRect cells, int tile = PHYSICS_TILE);
+
+    // the old layout: one edge fixture per cell wall on a single body
+    static b2Body* edgeBody(b2World* world, const Maze &maze);
+};
+
+#endif // MAZEPHYSICS_H
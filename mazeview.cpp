@@ -1,5 +1,9 @@
 #include "mazeview.h"
 #include "shader.h"
+#include "distancefield.h"
+#include "inputlog.h"
+#include "profiler.h"
+#include "allocationcounter.h"
 
 #include <QMatrix4x4>
 #include <QKeyEvent>
@@ -8,150 +12,121 @@
 
 #include <math.h>
 
+#include <algorithm>
 #include <iostream>
 
 #include "console.h"
 
+const int ALLOCATION_WARMUP_FRAMES = 240; // painted before frames have to stop allocating
+
 inline float randomFloat() {
     return ((float) rand()) / (float) RAND_MAX;
 }
 
-const float WALL_HEIGHT = 2.0f * 1.61;
-const float CELL_WIDTH = 2.0f;
-
-b2Vec2 dir(float angle)
+// Half the horizontal angle the camera can see on the ground plane. Tilting
+// the view up or down leans the top or bottom edge of the frustum forward,
+// which widens its footprint; once that edge passes the vertical every
+// direction is in view.
+static float viewHalfAngle(float fov, float aspect, float pitch)
 {
-    return b2Vec2(cos(angle), sin(angle));
+    const float halfV = 0.5f * fov * M_PI / 180.0f;
+    const float tanH = tan(halfV) * aspect;
+    const float forward = cos(pitch) - tan(halfV) * fabs(sin(pitch));
+    if (forward <= 0.0f)
+        return M_PI;
+    return atan2(tanH, forward);
 }
 
-QVector3D to3D(b2Vec2 v) {
-    return QVector3D((float)(v.x), (float)(v.y), 0.0f);
+// vsync for vsync pacing and none on demand, so input is painted at once;
+// capped leaves the driver's own setting alone
+static QGLFormat glFormat(const MazeOptions &options)
+{
+    QGLFormat format = QGLFormat::defaultFormat();
+    const FrameScheduler::Mode mode = FrameScheduler::modeNamed(options.pacing);
+    if (mode == FrameScheduler::VSYNC)
+        format.setSwapInterval(1);
+    else if (mode == FrameScheduler::ON_DEMAND)
+        format.setSwapInterval(0);
+    return format;
 }
 
-MazeView::MazeView(QWidget *parent) : QGLWidget(parent), lastTime(0)
+MazeView::MazeView(const MazeOptions &options, QWidget *parent) : QGLWidget(glFormat(options), parent)
 {
+    // before the simulation thread starts recording zones
+    profileTrace = options.profileTrace;
+    profilerGraph = options.profile ? new ProfilerGraph() : 0;
+    if (profilerGraph || !profileTrace.isEmpty())
+        Profiler::setEnabled(true);
+    Profiler::setThreadName("gui");
+    framesPainted = 0;
+    allocatingFrames = 0;
+    lateLatch = options.lateLatch;
+    measureLatency = options.latency;
+    shownSequence = 0;
+    latencyReport.start();
+
     setupEngine();
 
-    maze = new Maze(20, 20);
+    if (options.chunks > 0) {
+        // the walls all come from the streamed chunks
+        world = new ChunkedWorld(options.chunks, options.chunks);
+        maze = new Maze(0, 0);
+    } else {
+        world = 0;
+        maze = 0;
+        if (!options.mazeFile.isEmpty())
+            maze = Maze::load(options.mazeFile, &mazeExtras);
+        if (!maze)
+            maze = new Maze(20, 20);
+    }
+    // built here, uploaded by the first paint once there is a context
+    if (!world) {
+        const WallSegments segments(*maze);
+        segments.report(std::cout);
+        wallMesh.build(segments);
+    }
+    wallMeshDirty = true;
+    minimap.invalidate();
 
     setFocusPolicy(Qt::ClickFocus);
+    setAutoBufferSwap(false); // paintGL() swaps, to time it
     setMouseTracking(true);
 
-    updateTimer = new QTimer(this);
-    connect(updateTimer, SIGNAL(timeout()), this, SLOT(update()));
-    updateTimer->setInterval(10);
-    updateTimer->start();
-
-    elapsedTimer.start();
-
-    // http://www.bulletphysics.org/mediawiki-1.5.8/index.php/Hello_World
-    broadphase = new btDbvtBroadphase();
-    collisionConfiguration = new btDefaultCollisionConfiguration();
-    dispatcher = new btCollisionDispatcher(collisionConfiguration);
-    solver = new btSequentialImpulseConstraintSolver;
-    dynamicsWorld = new btDiscreteDynamicsWorld(dispatcher, broadphase, solver, collisionConfiguration);
-    dynamicsWorld->setGravity(btVector3(0, 0, -10));
-    groundShape = new btStaticPlaneShape(btVector3(0, 0, 1), 1);
-    fallShape = new btSphereShape(0.3f);
-
-    groundMotionState = new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1), btVector3(0, 0, -1)));
-    btRigidBody::btRigidBodyConstructionInfo groundRigidBodyCI(0, groundMotionState, groundShape, btVector3(0, 0, 0));
-    groundRigidBody = new btRigidBody(groundRigidBodyCI);
-    dynamicsWorld->addRigidBody(groundRigidBody);
-
-    fallMotionState = new btDefaultMotionState(btTransform(btQuaternion(0, 0, 0, 1), btVector3(0, 0, 50)));
-    btScalar mass = 1;
-    btVector3 fallInertia(0, 0, 0);
-    fallShape->calculateLocalInertia(mass, fallInertia);
-    btRigidBody::btRigidBodyConstructionInfo fallRigidBodyCI(mass, fallMotionState, fallShape, fallInertia);
-    fallRigidBody = new btRigidBody(fallRigidBodyCI);
-    dynamicsWorld->addRigidBody(fallRigidBody);
-
-    world = new b2World(b2Vec2(0.0f, 0.0f)); // no gravity
-
-    // create the ground
-    b2BodyDef groundBodyDef;
-    groundBodyDef.position.Set(0.0f, -10.0f);
-    groundBody = world->CreateBody(&groundBodyDef);
-    b2PolygonShape groundBox;
-    groundBox.SetAsBox(50.0f, 10.0f);
-    groundBody->CreateFixture(&groundBox, 0.0f);
-
-    // create the maze body
-    b2BodyDef mazeBodyDef;
-    mazeBody = world->CreateBody(&mazeBodyDef);
-    for (int row = 0; row < maze->height(); row++) {
-        for (int column = 0; column < maze->width(); column++) {
-            Cell cell = maze->cell(column, row);
-            if (cell.up) {
-                b2Vec2 v1(CELL_WIDTH * column, CELL_WIDTH * (row+1));
-                b2Vec2 v2(CELL_WIDTH * (column+1), CELL_WIDTH * (row+1));
-                b2EdgeShape edge;
-                edge.Set(v1, v2);
-
-                mazeBody->CreateFixture(&edge, 0.0f);
-            }
-            if (cell.left) {
-                b2Vec2 v1(CELL_WIDTH * column, CELL_WIDTH * row);
-                b2Vec2 v2(CELL_WIDTH * column, CELL_WIDTH * (row+1));
-                b2EdgeShape edge;
-                edge.Set(v1, v2);
-
-                mazeBody->CreateFixture(&edge, 0.0f);
-            }
-            if (cell.right && column == maze->width() - 1) {
-                b2Vec2 v1(CELL_WIDTH * (column+1), CELL_WIDTH * row);
-                b2Vec2 v2(CELL_WIDTH * (column+1), CELL_WIDTH * (row+1));
-                b2EdgeShape edge;
-                edge.Set(v1, v2);
-
-                mazeBody->CreateFixture(&edge, 0.0f);
-            }
+    scheduler = new FrameScheduler(this, FrameScheduler::modeNamed(options.pacing), options.fps, options.frameStats, this);
+
+    if (mazeExtras.hasEndpoints)
+        simulation = new Simulation(*maze, options.physics, mazeExtras.start, mazeExtras.goal, mazeExtras.distances);
+    else
+        simulation = new Simulation(*maze, options.physics);
+    std::cout << "goal: " << simulation->goal().x() << "," << simulation->goal().y() << std::endl;
+    showHints = options.hints;
+    software = options.renderer == "software" ? new SoftwareRenderer() : 0;
+
+    // saved with its endpoints and distances so loading it needs no search
+    if (!options.saveMazeFile.isEmpty()) {
+        MazeExtras extras;
+        if (simulation->startField()) {
+            extras.hasEndpoints = true;
+            extras.start = simulation->start();
+            extras.goal = simulation->goal();
+            extras.distances = simulation->startField()->distances();
         }
+        maze->save(options.saveMazeFile, extras);
     }
-
-    // create the body
-    b2BodyDef bodyDef;
-    bodyDef.type = b2_dynamicBody; // can move
-    bodyDef.position.Set(0.0f, 40.0f);
-    body = world->CreateBody(&bodyDef);
-    b2PolygonShape dynamicBox;
-    dynamicBox.SetAsBox(1.0f, 1.0f);
-    b2FixtureDef fixtureDef;
-    fixtureDef.shape = &dynamicBox; // is this a bug waiting to happen?
-    fixtureDef.density = 1.0f;
-    fixtureDef.friction = 0.3f;
-    body->CreateFixture(&fixtureDef);
-
-    // create the player
-    b2BodyDef playerDef;
-    playerDef.type = b2_dynamicBody;
-    playerDef.position.Set(0.5f, 0.5f);
-    playerBody = world->CreateBody(&playerDef);
-    b2CircleShape circle;
-    circle.m_radius = PLAYER_RADIUS;
-    b2FixtureDef playerFixtureDef;
-    playerFixtureDef.shape = &circle; // is this a bug waiting to happen?
-    playerFixtureDef.density = 1.0f;
-    playerFixtureDef.friction = 0.0f;
-    playerBody->CreateFixture(&playerFixtureDef);
-    playerBody->SetLinearVelocity(b2Vec2(0,0));
-
-
-    playerLeft = false;
-    playerRight = false;
-    playerForward = false;
-    playerBack = false;
-    playerStrafeLeft = false;
-    playerStrafeRight = false;
-    upDownAngle = 0.0f;
-
-    //goal = QPoint(randomFloat() * maze->width(), randomFloat() * maze->height());
-    goal = QPoint(2, 0);
-    start = QPoint(0, 0);
-    gameMode = GAME_SEARCHING;
-
-    std::cout << "goal: " << goal.x() << "," << goal.y() << std::endl;
+    if (world) {
+        world->update(QPoint(0, 0));
+        simulation->setChunkEvents(world->events());
+    }
+    recorder = 0;
+    if (!options.recordFile.isEmpty()) {
+        recorder = new InputRecorder(options.recordFile, *maze, options.physics, simulation->start(),
+                                     simulation->goal(), SIMULATION_STEP);
+        simulation->setRecorder(recorder);
+    }
+    simulationThread = new SimulationThread(simulation);
+    if (scheduler->mode() == FrameScheduler::ON_DEMAND)
+        connect(simulationThread, SIGNAL(changed()), scheduler, SLOT(requestFrame()));
+    simulationThread->start();
 }
 
 void MazeView::setupEngine()
@@ -191,18 +166,23 @@ void MazeView::setupEngine()
 
 MazeView::~MazeView()
 {
-    delete dynamicsWorld;
-    delete solver;
-    delete dispatcher;
-    delete collisionConfiguration;
-    delete broadphase;
-    delete groundShape;
-    delete fallShape;
-    delete groundMotionState;
-    delete groundRigidBody;
-
-    world->DestroyBody(groundBody);
+    // the chunk meshes, the wall mesh and the minimap free their buffers in
+    // our context
+    makeCurrent();
+
+    // the thread has to be gone before the world it steps
+    delete simulationThread;
+    delete recorder;
+    delete simulation;
     delete world;
+    delete software;
+    delete profilerGraph;
+
+    if (measureLatency)
+        mouseLatch.report();
+
+    if (!profileTrace.isEmpty())
+        Profiler::writeChromeTrace(profileTrace);
 }
 
 void MazeView::initializeGL()
@@ -220,27 +200,73 @@ void MazeView::initializeGL()
 void MazeView::resizeGL(int w, int h)
 {
     glViewport(0, 0, w, h);
+    minimap.invalidate();
+    if (software)
+        softwareFrame = QImage(w, h, QImage::Format_RGB32);
 
     update();
 }
 
 void MazeView::paintGL()
 {
-    if (gameMode == GAME_MINIGAME)
-        updateMiniGame();
-    else
-        updateWorld();
+    scheduler->frameStarted();
+    ProfileZone zone("frame");
+    // asking the window system where the cursor is allocates, so before the check
+    if (lateLatch)
+        sampleMouse();
+    const AllocationCount before = AllocationCounter::thread();
+    paintFrame();
+    checkAllocations(before);
+
+    // to the right of the minimap, and left out of the check: text allocates
+    if (profilerGraph) {
+        ProfileZone graphZone("profiler");
+        QPainter painter(this);
+        profilerGraph->draw(painter, QRect(MINIMAP_SIZE + 8, height() - MINIMAP_SIZE, PROFILER_GRAPH_WIDTH, MINIMAP_SIZE));
+    }
 
-    // see if at end
-    QPoint currentCell(playerBody->GetPosition().x / CELL_WIDTH, playerBody->GetPosition().y / CELL_WIDTH);
-    if (currentCell == goal && gameMode == GAME_SEARCHING) {
-        gameMode = GAME_MINIGAME;
+    {
+        ProfileZone swapZone("swap");
+        swapBuffers();
     }
 
+    // the swap only queues the frame; waiting for the GPU makes the time
+    // the one it's actually done at
+    if (measureLatency) {
+        glFinish();
+        mouseLatch.shown(shownSequence, simulationThread->now());
+        if (latencyReport.elapsed() >= 5000) {
+            latencyReport.restart();
+            mouseLatch.report();
+        }
+    }
+    scheduler->frameFinished();
+}
 
-    QPainter painter(this);
+void MazeView::paintFrame()
+{
+    // draw the player between the last two steps the simulation published
+    const SimulationSnapshot &snapshot = simulationThread->snapshot();
+    const double sinceStep = (simulationThread->now() - snapshot.stepTime) * 1e-9;
+    const float alpha = std::min(1.0f, std::max(0.0f, (float)(sinceStep / simulationThread->step())));
+    PlayerPose pose = PlayerPose::lerp(snapshot.previous, snapshot.current, alpha);
+    float upDownAngle = snapshot.upDownAngle;
+
+    if (lateLatch) {
+        // mouse turns aren't eased in like the rest of a step: the last
+        // step's shows whole, and the moves it hasn't applied yet on top
+        const QPoint pending = mouseLatch.pending(snapshot.mouseSequence);
+        pose.angle += (1.0f - alpha) * snapshot.mouseTurn + Simulation::mouseTurn(pending.x());
+        upDownAngle += Simulation::mouseTilt(pending.y());
+        shownSequence = mouseLatch.newest();
+    } else {
+        shownSequence = snapshot.mouseSequence;
+    }
 
-    painter.beginNativePainting();
+    if (software) {
+        paintSoftware(snapshot, pose, upDownAngle);
+        return;
+    }
 
     glEnable(GL_DEPTH_TEST);
 
@@ -248,9 +274,10 @@ void MazeView::paintGL()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     const float FOV = 45;
+    const float FAR_PLANE = 100;
     float aspect = width() / (float)height();
     QMatrix4x4 proj;
-    proj.perspective(45, aspect, 0.2, 100);
+    proj.perspective(FOV, aspect, 0.2, FAR_PLANE);
 
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
@@ -259,12 +286,11 @@ void MazeView::paintGL()
     QMatrix4x4 camera;
 
 
-    float currentAngle = playerBody->GetAngle();
+    float currentAngle = pose.angle;
     b2Vec2 lookDir = dir(currentAngle);
-    b2Vec2 position = body->GetPosition();
 
 #if 1
-    QVector3D playerPos((float)(playerBody->GetPosition().x), (float)(playerBody->GetPosition().y), 1.0f);
+    QVector3D playerPos(pose.x, pose.y, 1.0f);
     QVector3D lookDir3D = QVector3D((float)(lookDir.x), (float)(lookDir.y), tan(upDownAngle));
 
     camera.lookAt(playerPos,
@@ -275,7 +301,7 @@ void MazeView::paintGL()
     const float CAMERA_HEIGHT = 30;
     const float R = CAMERA_HEIGHT * tan(FOV*0.5f);
     std::cout << R << std::endl;
-    QVector3D playerPos((float)(playerBody->GetPosition().x), (float)(playerBody->GetPosition().y), 1.0f);
+    QVector3D playerPos(pose.x, pose.y, 1.0f);
     QVector3D lookFrom = playerPos + QVector3D(0,0,CAMERA_HEIGHT);
     camera.lookAt(lookFrom,
                   playerPos,
@@ -294,50 +320,27 @@ void MazeView::paintGL()
     wallShader->bind();
 
 
-    glBegin(GL_QUADS);
     {
-        for (int row = 0; row < maze->height(); row++) {
-            for (int column = 0; column < maze->width(); column++) {
-                Cell cell = maze->cell(column, row);
-
-                const int x = column;
-                const int y = row;
-
-                // TODO: toss this in a cache
-                // cells around current cell (row-ordered top to bottom)
-                Cell c1 = maze->cell(column-1, row+1);
-                Cell c2 = maze->cell(column, row+1);
-                Cell c3 = maze->cell(column+1, row+1);
-                Cell c4 = maze->cell(column-1, row);
-                Cell c5 = maze->cell(column, row); // drawing this one
-                Cell c6 = maze->cell(column + 1, row);
-                Cell c7 = maze->cell(column - 1, row - 1);
-                Cell c8 = maze->cell(column, row - 1);
-                Cell c9 = maze->cell(column + 1, row - 1);
-
-                glColor3f(1,0,0); //red
-                if (cell.up)
-                    drawWall(QPoint(CELL_WIDTH*x, CELL_WIDTH*(y+1)), QVector2D(1,0), c1.right, c1.down, c4.right, c5.right, c6.up, c3.left);
-
-                glColor3f(1,1,0); // yellow
-                if (cell.down) {
-                    drawWall(QPoint(CELL_WIDTH*(x+1), CELL_WIDTH*y), QVector2D(-1,0), c8.right, c6.down, c5.right, c4.right, c4.down, c7.right);
-                }
-
-                glColor3f(1,0,1); // purple
-                if (cell.left) {
-                    drawWall(QPoint(CELL_WIDTH*x,CELL_WIDTH*y), QVector2D(0,1), c7.up, c7.right, c5.down, c5.up, c2.left, c1.down);
-                }
-
-                glColor3f(0,1,1); // cyan
-                if (cell.right) {
-                    drawWall(QPoint(CELL_WIDTH*(x+1),CELL_WIDTH*(y+1)), QVector2D(0,-1), c3.down, c3.left, c5.up, c5.down, c8.right, c9.up);
-                }
-            }
+        ProfileZone wallsZone("walls");
+        if (wallMeshDirty) {
+            wallMesh.upload();
+            wallMeshDirty = false;
+        }
+        if (world) {
+            world->update(QPoint(pose.x / CELL_WIDTH, pose.y / CELL_WIDTH));
+            world->draw();
+        } else {
+            // only the walls of cells seen through the doorways from here
+            const float pitch = atan(fabs(tan(upDownAngle)));
+            visibility.update(*maze, QVector2D(pose.x, pose.y), currentAngle, viewHalfAngle(FOV, aspect, pitch), FAR_PLANE);
+            wallMesh.drawCells(visibility.cells());
         }
+    }
 
-        float x = position.x;
-        float y = position.y;
+    glBegin(GL_QUADS);
+    for (int i = 0; i < snapshot.propCount; i++) {
+        float x = snapshot.props[i].x;
+        float y = snapshot.props[i].y;
         glColor3f(1,1,1);
         glVertex2f(x-1, y);
         glVertex2f(x, y);
@@ -365,7 +368,7 @@ void MazeView::paintGL()
 
     // draw player
     glColor3f(1,1,1);
-    b2Vec2 playerP = playerBody->GetPosition();
+    b2Vec2 playerP(pose.x, pose.y);
     glTranslatef(playerP.x, playerP.y, 0);
     glBegin(GL_TRIANGLE_FAN);
     {
@@ -395,7 +398,8 @@ void MazeView::paintGL()
 
     // draw goal
     //
-    if (gameMode == GAME_SEARCHING) {
+    if (snapshot.gameMode == GAME_SEARCHING) {
+        const QPoint goal = simulation->goal();
         QVector2D center(CELL_WIDTH * goal.x() + 0.5f*CELL_WIDTH, CELL_WIDTH * goal.y() + 0.5f*CELL_WIDTH);
         glBegin(GL_QUADS);
         {
@@ -407,9 +411,25 @@ void MazeView::paintGL()
         glEnd();
     }
 
+    // draw the hint, a low marker in the next cell to head for
+    //
+    if (showHints && snapshot.gameMode != GAME_MINIGAME) {
+        QVector2D center(CELL_WIDTH * snapshot.hint.x() + 0.5f*CELL_WIDTH, CELL_WIDTH * snapshot.hint.y() + 0.5f*CELL_WIDTH);
+        glColor3f(0,1,0);
+        glBegin(GL_QUADS);
+        {
+            glVertex3f(center.x() - 0.2f, center.y() - 0.2f, 0.05f);
+            glVertex3f(center.x() + 0.2f, center.y() - 0.2f, 0.05f);
+            glVertex3f(center.x() + 0.2f, center.y() + 0.2f, 0.05f);
+            glVertex3f(center.x() - 0.2f, center.y() + 0.2f, 0.05f);
+        }
+        glEnd();
+    }
+
     // draw the exit
     //
-    if (gameMode == GAME_FLEEING) {
+    if (snapshot.gameMode == GAME_FLEEING) {
+        const QPoint start = simulation->start();
         QVector2D center(CELL_WIDTH * start.x() + 0.5f*CELL_WIDTH, CELL_WIDTH * start.y() + 0.5f*CELL_WIDTH);
         glColor3f(1,1,1);
         glBegin(GL_QUADS);
@@ -424,143 +444,80 @@ void MazeView::paintGL()
 
     glDisable(GL_DEPTH_TEST);
 
-    painter.endNativePainting();
-
-    drawMazeOverlay(painter);
-
-    painter.end();
-}
-
-void MazeView::updateMiniGame()
-{
-
+    {
+        ProfileZone overlayZone("overlay");
+        minimap.drawGL(*maze, QPointF(pose.x / CELL_WIDTH, pose.y / CELL_WIDTH), size());
+    }
 }
 
-void MazeView::updateWorld()
+// the raycast view, with the goal or exit post but without the props,
+// ground grid and player disc of the GL path
+void MazeView::paintSoftware(const SimulationSnapshot &snapshot, const PlayerPose &pose, float upDownAngle)
 {
-    int newTime = elapsedTimer.elapsed();
-    int elapsed = newTime - lastTime;
-    lastTime = newTime;
-
-    float elapsedSeconds = elapsed * 0.001f;
-    dynamicsWorld->stepSimulation(elapsedSeconds, 10);
-    btTransform trans;
-    fallRigidBody->getMotionState()->getWorldTransform(trans);
-
-    world->Step(elapsedSeconds, 6, 2);
-    b2Vec2 position = body->GetPosition();
-
-    float currentAngle = playerBody->GetAngle();
-
-    b2Vec2 lookDir = dir(currentAngle);
-    if (playerForward) {
-        b2Vec2 v = playerBody->GetLinearVelocity();
-        b2Vec2 newV = ACCELERATION * elapsedSeconds * lookDir + v;
-        float l = std::min(MAX_FORWARD_VELOCITY, newV.Length());
-        newV.Normalize();
-        newV *= l;
-        playerBody->SetLinearVelocity(newV);
-    } else if (playerBack) {
-        b2Vec2 v = playerBody->GetLinearVelocity();
-        b2Vec2 newV = -ACCELERATION * elapsedSeconds * lookDir + v;
-        float l = std::min(MAX_BACKWARD_VELOCITY, newV.Length());
-        newV.Normalize();
-        newV *= l;
-        playerBody->SetLinearVelocity(newV);
-    } else { // slow down
-        b2Vec2 v = playerBody->GetLinearVelocity();
-
-        // adjust velocity to be where player is facing
-        float l = v.Length();
-        if (l > 0) {
-            l -= elapsedSeconds * ACCELERATION;
-            l = std::max(0.0f, l);
-        } else {
-            l += elapsedSeconds * ACCELERATION;
-            l = std::min(0.0f, l);
-        }
-        v.Normalize();
-        v *= l;
-        playerBody->SetLinearVelocity(v);
-    }
-
-    if (playerStrafeLeft) {
-        QVector3D lookDir3D = to3D(lookDir);
-        QVector3D leftDir = QVector3D::crossProduct(lookDir3D, QVector3D(0,0,-1));
-        leftDir.normalize();
-
-        b2Vec2 v = playerBody->GetLinearVelocity();
-        float currentLeftV = QVector3D::dotProduct(leftDir, to3D(v)) / v.Length();
-        if (v.Length() < 0.001f || currentLeftV < MAX_STRAFE_VELOCITY) { // can strafe left
-            b2Vec2 newV = ACCELERATION * elapsedSeconds * b2Vec2(leftDir.x(), leftDir.y()) + v;
-            playerBody->SetLinearVelocity(newV);
-        }
-    } else if (playerStrafeRight) {
-        QVector3D lookDir3D = to3D(lookDir);
-        QVector3D rightDir = QVector3D::crossProduct(lookDir3D, QVector3D(0,0,1));
-        rightDir.normalize();
-
-        b2Vec2 v = playerBody->GetLinearVelocity();
-        float currentRightV = QVector3D::dotProduct(rightDir, to3D(v)) / v.Length();
-        if (v.Length() < 0.001f || currentRightV < MAX_STRAFE_VELOCITY) { // can strafe right
-            b2Vec2 newV = ACCELERATION * elapsedSeconds * b2Vec2(rightDir.x(), rightDir.y()) + v;
-            playerBody->SetLinearVelocity(newV);
-        }
-    } else {
-        //player.sidewaysDown(elapsed);
+    markers.resize(0);
+    if (snapshot.gameMode == GAME_SEARCHING || snapshot.gameMode == GAME_FLEEING) {
+        const QPoint cell = snapshot.gameMode == GAME_SEARCHING ? simulation->goal() : simulation->start();
+        RenderMarker marker;
+        marker.position = QPointF(CELL_WIDTH * cell.x() + 0.5f*CELL_WIDTH, CELL_WIDTH * cell.y() + 0.5f*CELL_WIDTH);
+        marker.color = snapshot.gameMode == GAME_SEARCHING ? qRgb(0, 0, 255) : qRgb(255, 255, 255);
+        markers.append(marker);
     }
 
-    if (playerLeft && !playerRight) {
-        float v = playerBody->GetAngularVelocity();
-        v += elapsedSeconds * TURN_ACCELERATION;
-        v = std::min(MAX_TURN_VELOCITY, v);
-        playerBody->SetAngularVelocity(v);
-    } else if (playerRight && !playerLeft) {
-        float v = playerBody->GetAngularVelocity();
-        v -= elapsedSeconds * TURN_ACCELERATION;
-        v = std::max(-MAX_TURN_VELOCITY, v);
-        playerBody->SetAngularVelocity(v);
-    } else { // slow down
-        float v = playerBody->GetAngularVelocity();
-        if (v > 0) {
-            v -= elapsedSeconds * TURN_ACCELERATION;
-            v = std::max(0.0f, v);
-            playerBody->SetAngularVelocity(v);
-        } else {
-            v += elapsedSeconds * TURN_ACCELERATION;
-            v = std::min(0.0f, v);
-            playerBody->SetAngularVelocity(v);
-        }
+    {
+        ProfileZone zone("software");
+        software->render(softwareFrame, *maze, pose, upDownAngle, markers);
     }
 
-    if (lastMouseDiff.x() != 0) {
-        float newAngle = playerBody->GetAngle() + lastMouseDiff.x() * -0.0005f;
-        playerBody->SetTransform(playerBody->GetPosition(), newAngle);
-        //std::cout << newAngle << std::endl;
-    }
-    if (lastMouseDiff.y() != 0) {
-        upDownAngle += lastMouseDiff.y() * 0.0005f;
+    QPainter painter(this);
+    painter.drawImage(0, 0, softwareFrame);
+    {
+        ProfileZone zone("overlay");
+        minimap.draw(painter, *maze, QPointF(pose.x / CELL_WIDTH, pose.y / CELL_WIDTH), height());
     }
-    lastMouseDiff = QPoint(0,0);
+    painter.end();
 }
 
 void MazeView::mousePressEvent(QMouseEvent *event)
 {
     grabMouse();
     setCursor(Qt::BlankCursor);
+    lastMouseP = event->pos();
 }
 
 void MazeView::mouseMoveEvent(QMouseEvent *event)
 {
     if (cursor().shape() == Qt::BlankCursor) {
-        lastMouseDiff = lastMouseP - event->pos();
-        lastMouseP = event->pos();
+        moveMouse(event->pos());
+        scheduler->requestFrame();
+    }
+}
 
-        QPoint centerOfScreen = mapToGlobal(QPoint(width() / 2, height() / 2));
-        QCursor::setPos(centerOfScreen);
+// Every move is posted, the simulation sums whatever arrives between two
+// steps. The cursor goes back to the middle only once it has wandered off,
+// and counts as being there, so the move the warp itself makes comes out as
+// nothing.
+void MazeView::moveMouse(QPoint position)
+{
+    const QPoint diff = lastMouseP - position;
+    lastMouseP = position;
+    if (diff.isNull())
+        return;
+    post(InputEvent::MOUSE_MOVE, 0, diff.x(), diff.y());
+
+    const QPoint center(width() / 2, height() / 2);
+    if ((position - center).manhattanLength() > std::min(width(), height()) / 4) {
+        QCursor::setPos(mapToGlobal(center));
+        lastMouseP = center;
     }
 }
 
+// where the cursor is now, ahead of any move event still on its way
+void MazeView::sampleMouse()
+{
+    if (cursor().shape() == Qt::BlankCursor)
+        moveMouse(mapFromGlobal(QCursor::pos()));
+}
+
 
 void MazeView::keyPressEvent(QKeyEvent *event)
 {
@@ -569,148 +526,73 @@ void MazeView::keyPressEvent(QKeyEvent *event)
         setCursor(Qt::ArrowCursor);
     }
 
-    // forward and back
-    if (event->key() == Qt::Key_W && !playerBack) {
-        playerForward = true;
-    } else if (event->key() == Qt::Key_S && !playerForward) {
-        playerBack = true;
-    }
-
-    // turning
-    if (event->key() == Qt::Key_Q) {
-        playerLeft = true;
-    } else if (event->key() == Qt::Key_E) {
-        playerRight = true;
-    }
-
-    // stafing
-    if (event->key() == Qt::Key_A) {
-        playerStrafeLeft = true;
-    } else if (event->key() == Qt::Key_D) {
-        playerStrafeRight = true;
+    const int key = keyBit(event->key());
+    if (key && !event->isAutoRepeat()) {
+        post(InputEvent::KEY_DOWN, key);
+        scheduler->requestFrame();
     }
 }
 
 void MazeView::keyReleaseEvent(QKeyEvent *event)
 {
-    if (event->key() == Qt::Key_W) {
-        playerForward = false;
-    } else if (event->key() == Qt::Key_S) {
-        playerBack = false;
-    } else if (event->key() == Qt::Key_Q) {
-        playerLeft = false;
-    } else if (event->key() == Qt::Key_E) {
-        playerRight = false;
-    } else if (event->key() == Qt::Key_A) {
-        playerStrafeLeft = false;
-    } else if (event->key() == Qt::Key_D) {
-        playerStrafeRight = false;
+    const int key = keyBit(event->key());
+    if (key && !event->isAutoRepeat()) {
+        post(InputEvent::KEY_UP, key);
+        scheduler->requestFrame();
     }
 }
 
-std::string toStr(QVector3D v) {
-    return QString("(%1, %2, %3)").arg(v.x()).arg(v.y()).arg(v.z()).toStdString();
-}
-
-void MazeView::drawWall(QPoint pXY, QVector2D basisBottom, bool w1, bool w2, bool w3, bool w4, bool w5, bool w6)
+// W/S forward and back, Q/E turning, A/D strafing
+int MazeView::keyBit(int qtKey)
 {
-    const float OFFSET = 0.1f;
-
-    QVector3D start(pXY);
-    QVector3D basisTop(0, 0, 1);
-    QVector3D basisOut = QVector3D::crossProduct(basisBottom, basisTop);
-    QVector3D basisIn = -1 * basisOut;
-
-    float wallLength = CELL_WIDTH; //1.0f;
-    QVector3D cornerA;
-    if (w3) {
-        cornerA = start + (basisBottom * OFFSET) + (basisOut * OFFSET);
-        wallLength -= OFFSET;
-    } else if (w2) {
-        cornerA = start + basisOut * OFFSET;
-    } else {
-        cornerA = start + (basisOut * OFFSET) + (basisBottom * -OFFSET);
-        wallLength += OFFSET;
-    }
-
-    if (w4) {
-        wallLength -= OFFSET;
-    } else if (w6) {
-        wallLength += OFFSET;
-    } else if (!w5) {
-        wallLength += OFFSET;
-    }
-
-    QVector3D cornerB = cornerA + basisBottom * wallLength;
-    QVector3D cornerC = cornerB + basisTop*WALL_HEIGHT;
-    QVector3D cornerD = cornerA + basisTop*WALL_HEIGHT;
-
-    // draw wall
-    glVertex3f(cornerA.x(), cornerA.y(), cornerA.z());
-    glVertex3f(cornerB.x(), cornerB.y(), cornerB.z());
-    glVertex3f(cornerC.x(), cornerC.y(), cornerC.z());
-    glVertex3f(cornerD.x(), cornerD.y(), cornerD.z());
-
-    // draw caps
-    if (!w1 && !w2) {
-        QVector3D in = basisIn * OFFSET;
-        QVector3D top = cornerD + in;
-        QVector3D bottom = cornerA + in;
-
-        glVertex3f(cornerA.x(), cornerA.y(), cornerA.z());
-        glVertex3f(cornerD.x(), cornerD.y(), cornerD.z());
-        glVertex3f(top.x(), top.y(), top.z());
-        glVertex3f(bottom.x(), bottom.y(), bottom.z());
-    }
-    if (!w5 && !w6) {
-        QVector3D in = basisIn * OFFSET;
-        QVector3D top = cornerC + in;
-        QVector3D bottom = cornerB + in;
-
-        glVertex3f(cornerB.x(), cornerB.y(), cornerB.z());
-        glVertex3f(bottom.x(), bottom.y(), bottom.z());
-        glVertex3f(top.x(), top.y(), top.z());
-        glVertex3f(cornerC.x(), cornerC.y(), cornerC.z());
+    switch (qtKey) {
+    case Qt::Key_W: return KEY_FORWARD;
+    case Qt::Key_S: return KEY_BACK;
+    case Qt::Key_Q: return KEY_TURN_LEFT;
+    case Qt::Key_E: return KEY_TURN_RIGHT;
+    case Qt::Key_A: return KEY_STRAFE_LEFT;
+    case Qt::Key_D: return KEY_STRAFE_RIGHT;
     }
+    return 0;
 }
 
-void MazeView::drawMazeOverlay(QPainter &painter)
+void MazeView::post(int type, int key, int dx, int dy)
 {
-    QPen penHText(QColor("#00ff00"));
-    painter.setPen(penHText);
-    //painter.setBrush(Qt::white);
-
-    QMatrix prevMatrix = painter.matrix();
-
-    QMatrix flipMatrix;
-    flipMatrix.translate(0, height());
-    flipMatrix.scale(1,-1);
-    painter.setMatrix(flipMatrix);
-
-    painter.fillRect(0, 0, 250, 250, Qt::gray);
-
-    for (int row = 0; row < maze->height(); row++) {
-        for (int column = 0; column < maze->width(); column++) {
-            Cell cell = maze->cell(column, row);
-
-            const int x = column * 20 + 20;
-            const int y = row * 20 + 20;
-
-            if (cell.up)
-                painter.drawLine(x, y+18, x+18, y+18);
-            if (cell.down)
-                painter.drawLine(x, y, x+18, y);
-            if (cell.left)
-                painter.drawLine(x, y, x, (y+18));
-            if (cell.right)
-                painter.drawLine(x+18, y, x+18, (y+18));
-        }
+    InputEvent event;
+    event.type = type;
+    event.key = key;
+    event.dx = dx;
+    event.dy = dy;
+    event.sequence = type == InputEvent::MOUSE_MOVE ? mouseLatch.next() : 0;
+    const qint64 time = simulationThread->now();
+    if (!simulationThread->post(event)) {
+        std::cerr << "input queue full, dropped an event" << std::endl;
+        return;
     }
 
-    // draw the player
-    b2Vec2 p = playerBody->GetPosition();
-    QVector3D playerPos(p.x / CELL_WIDTH, p.y / CELL_WIDTH, 0);
-    painter.drawRect(20*playerPos.x() - 1 + 20, 20*playerPos.y() - 1 + 20, 2, 2);
+    // a dropped move would stay pending and never reach the screen
+    if (type == InputEvent::MOUSE_MOVE)
+        mouseLatch.posted(QPoint(dx, dy), time);
+}
 
-    painter.setMatrix(prevMatrix);
+// Once warmed up a frame of the GL view makes no heap allocations; builds
+// with the allocation counter say so when one does, at most once a second.
+// The software view hands its rows to a thread pool, which allocates.
+void MazeView::checkAllocations(const AllocationCount &before)
+{
+    if (!AllocationCounter::available() || software)
+        return;
+
+    framesPainted++;
+    const AllocationCount after = AllocationCounter::thread();
+    const quint64 allocations = after.allocations - before.allocations;
+    if (allocations == 0 || framesPainted <= ALLOCATION_WARMUP_FRAMES)
+        return;
+
+    allocatingFrames++;
+    if (allocationWarning.isValid() && allocationWarning.elapsed() < 1000)
+        return;
+    allocationWarning.start();
+    std::cerr << "frame " << framesPainted << " made " << allocations << " heap allocations of "
+              << (after.bytes - before.bytes) << " bytes, " << allocatingFrames << " such frames so far" << std::endl;
 }
@@ -3,26 +3,30 @@
 
 #include "maze.h"
 #include "player.h"
+#include "wallmesh.h"
+#include "portalvisibility.h"
+#include "minimap.h"
+#include "chunkedworld.h"
+#include "options.h"
+#include "simulation.h"
+#include "simulationthread.h"
+#include "softwarerenderer.h"
+#include "profilergraph.h"
+#include "allocationcounter.h"
+#include "framescheduler.h"
+#include "mouselatch.h"
 
 #include <QWidget>
 #include <QGLWidget>
-#include <QTimer>
 #include <QElapsedTimer>
 #include <QGLShaderProgram>
 #include <QScriptEngine>
 
-#include <btBulletDynamicsCommon.h>
-#include <Box2D/Box2D.h>
-
-const float PLAYER_RADIUS = 0.5f;
-
-enum { GAME_SEARCHING, GAME_MINIGAME, GAME_FLEEING };
-
 class MazeView : public QGLWidget
 {
     Q_OBJECT
 public:
-    explicit MazeView(QWidget *parent = 0);
+    explicit MazeView(const MazeOptions &options, QWidget *parent = 0);
     ~MazeView();
     void initializeGL();
     void resizeGL(int w, int h);
@@ -37,52 +41,43 @@ signals:
 public slots:
 private:
     void setupEngine();
-    void updateMiniGame();
-    void updateWorld();
-    void drawWall(QPoint p, QVector2D basis, bool w1, bool w2, bool w3, bool w4, bool w5, bool w6);
-    void drawMazeOverlay(QPainter &painter);
+    void post(int type, int key, int dx = 0, int dy = 0);
+    static int keyBit(int qtKey);
+    void paintFrame();
+    void checkAllocations(const AllocationCount &before);
+    void paintSoftware(const SimulationSnapshot &snapshot, const PlayerPose &pose, float upDownAngle);
+    void moveMouse(QPoint position);
+    void sampleMouse();
     QScriptEngine* engine;
     Maze* maze;
+    MazeExtras mazeExtras; // whatever came with a loaded maze
+    ChunkedWorld* world; // streamed walls instead of maze, if not null
+    WallMesh wallMesh;
+    bool wallMeshDirty; // uploaded on the next paint
+    PortalVisibility visibility;
+    MinimapCache minimap;
+    bool showHints;
+    SoftwareRenderer* software; // draws instead of GL, if not null
+    QImage softwareFrame;
+    QVector<RenderMarker> markers; // reused by every software frame
+    ProfilerGraph* profilerGraph; // if profiling
+    QString profileTrace; // written on exit, if set
+    int framesPainted; // counted only with the allocation counter
+    int allocatingFrames; // of them, after the warm-up
+    QElapsedTimer allocationWarning; // since the last one
     //Player player;
-    QTimer* updateTimer;
+    FrameScheduler* scheduler; // when to paint next
 
-    QElapsedTimer elapsedTimer;
-    int lastTime;
+    Simulation* simulation;
+    SimulationThread* simulationThread;
+    InputRecorder* recorder; // if recording
 
     QPoint lastMouseP;
-    QPoint lastMouseDiff;
-    float upDownAngle;
-
-    bool playerForward;
-    bool playerBack;
-    bool playerLeft;
-    bool playerRight;
-    bool playerStrafeLeft;
-    bool playerStrafeRight;
-
-    // bullet physics
-    btBroadphaseInterface* broadphase;// = new btDbvtBroadphase();
-    btDefaultCollisionConfiguration* collisionConfiguration;
-    btCollisionDispatcher* dispatcher;
-    btSequentialImpulseConstraintSolver* solver;
-    btDiscreteDynamicsWorld* dynamicsWorld;
-    btCollisionShape* groundShape;
-    btCollisionShape* fallShape;
-    btDefaultMotionState* groundMotionState;
-    btRigidBody* groundRigidBody;
-    btDefaultMotionState* fallMotionState;
-    btRigidBody* fallRigidBody;
-
-    b2World* world;
-    b2Body* mazeBody;
-    b2Body* groundBody;
-    b2Body* body;
-    b2Body* playerBody;
-
-    QPoint goal;
-    QPoint start;
-
-    int gameMode;
+    MouseLatch mouseLatch; // moves posted and not yet simulated, and their latency
+    bool lateLatch; // sample the mouse before painting and draw the pending moves
+    bool measureLatency;
+    quint32 shownSequence; // newest mouse move in the frame being painted
+    QElapsedTimer latencyReport; // since the latency was last printed
 
     QGLShaderProgram* wallShader;
 };
@@ -0,0 +1,211 @@
+#include "minimap.h"
+
+#include <QPen>
+#include <QMatrix>
+
+#include <math.h>
+#include <algorithm>
+
+static const QColor WALL_COLOR("#00ff00");
+
+MinimapCache::MinimapCache() : _valid(false), _windowed(false), _texture(0), _textureDirty(false)
+{
+}
+
+MinimapCache::~MinimapCache()
+{
+    if (_texture)
+        glDeleteTextures(1, &_texture);
+}
+
+// the walls of the given cells, cell (cells.left(), cells.top()) at origin
+void MinimapCache::drawWalls(QPainter &painter, const Maze &maze, QRect cells, QPoint origin)
+{
+    painter.setPen(QPen(WALL_COLOR));
+    for (int row = cells.top(); row <= cells.bottom(); row++) {
+        const WallRow walls = maze.row(row);
+        for (int column = cells.left(); column <= cells.right(); column++) {
+            const int x = origin.x() + (column - cells.left()) * MINIMAP_PITCH;
+            const int y = origin.y() + (row - cells.top()) * MINIMAP_PITCH;
+
+            if (walls.up(column))
+                painter.drawLine(x, y+18, x+18, y+18);
+            if (walls.down(column))
+                painter.drawLine(x, y, x+18, y);
+            if (walls.left(column))
+                painter.drawLine(x, y, x, (y+18));
+            if (walls.right(column))
+                painter.drawLine(x+18, y, x+18, (y+18));
+        }
+    }
+}
+
+void MinimapCache::renderFull(const Maze &maze)
+{
+    const int w = std::max(MINIMAP_SIZE, (maze.width() + 1) * MINIMAP_PITCH);
+    const int h = std::max(MINIMAP_SIZE, (maze.height() + 1) * MINIMAP_PITCH);
+    if (_image.width() != w || _image.height() != h)
+        _image = QImage(w, h, QImage::Format_ARGB32_Premultiplied);
+    _image.fill(Qt::transparent);
+
+    QPainter painter(&_image);
+    painter.fillRect(0, 0, MINIMAP_SIZE, MINIMAP_SIZE, Qt::gray);
+    drawWalls(painter, maze, QRect(0, 0, maze.width(), maze.height()), QPoint(MINIMAP_PITCH, MINIMAP_PITCH));
+    _textureDirty = true;
+}
+
+void MinimapCache::renderRegion(const Maze &maze, QRect cells)
+{
+    const int side = MINIMAP_REGION * MINIMAP_PITCH;
+    if (_image.width() != side || _image.height() != side)
+        _image = QImage(side, side, QImage::Format_ARGB32_Premultiplied);
+    _image.fill(Qt::transparent);
+
+    QPainter painter(&_image);
+    drawWalls(painter, maze, cells, QPoint(0, 0));
+    _region = cells;
+    _textureDirty = true;
+}
+
+// the cached image current for where the player is
+void MinimapCache::refresh(const Maze &maze, QPointF player)
+{
+    if (!_valid) {
+        _windowed = (maze.width() + 1) * MINIMAP_PITCH > MINIMAP_MAX_FULL ||
+                    (maze.height() + 1) * MINIMAP_PITCH > MINIMAP_MAX_FULL;
+        if (!_windowed)
+            renderFull(maze);
+        _region = QRect();
+        _valid = true;
+    }
+
+    if (_windowed) {
+        // cells the backdrop can show with the player in the middle
+        const int half = MINIMAP_SIZE / (2 * MINIMAP_PITCH) + 1;
+        const QPoint cell((int)floor(player.x()), (int)floor(player.y()));
+        const QRect window(cell.x() - half, cell.y() - half, 2*half + 1, 2*half + 1);
+        const QRect mazeCells(0, 0, maze.width(), maze.height());
+        if (_region.isNull() || !_region.contains(window & mazeCells)) {
+            const int left = std::max(0, std::min(cell.x() - MINIMAP_REGION/2, maze.width() - MINIMAP_REGION));
+            const int top = std::max(0, std::min(cell.y() - MINIMAP_REGION/2, maze.height() - MINIMAP_REGION));
+            renderRegion(maze, QRect(left, top, MINIMAP_REGION, MINIMAP_REGION) & mazeCells);
+        }
+    }
+}
+
+void MinimapCache::draw(QPainter &painter, const Maze &maze, QPointF player, int viewHeight)
+{
+    refresh(maze, player);
+
+    QMatrix prevMatrix = painter.matrix();
+
+    // y up from the bottom left corner, same as the maze
+    QMatrix flipMatrix;
+    flipMatrix.translate(0, viewHeight);
+    flipMatrix.scale(1,-1);
+    painter.setMatrix(flipMatrix);
+    painter.setPen(QPen(WALL_COLOR));
+
+    if (!_windowed) {
+        painter.drawImage(0, 0, _image);
+
+        // draw the player
+        painter.drawRect(MINIMAP_PITCH*player.x() - 1 + MINIMAP_PITCH, MINIMAP_PITCH*player.y() - 1 + MINIMAP_PITCH, 2, 2);
+    } else {
+        const float center = 0.5f * MINIMAP_SIZE;
+        painter.save();
+        painter.setClipRect(0, 0, MINIMAP_SIZE, MINIMAP_SIZE);
+        painter.fillRect(0, 0, MINIMAP_SIZE, MINIMAP_SIZE, Qt::gray);
+        painter.drawImage(QPointF(center - (player.x() - _region.left()) * MINIMAP_PITCH,
+                                  center - (player.y() - _region.top()) * MINIMAP_PITCH), _image);
+        painter.restore();
+
+        // the player stays in the middle
+        painter.drawRect(center - 1, center - 1, 2, 2);
+    }
+
+    painter.setMatrix(prevMatrix);
+}
+
+// image rows go up the screen, as the flipped painter draws them
+static void texturedQuad(float x, float y, float w, float h)
+{
+    glBegin(GL_QUADS);
+    glTexCoord2f(0, 0); glVertex2f(x, y);
+    glTexCoord2f(1, 0); glVertex2f(x + w, y);
+    glTexCoord2f(1, 1); glVertex2f(x + w, y + h);
+    glTexCoord2f(0, 1); glVertex2f(x, y + h);
+    glEnd();
+}
+
+// the same outline QPainter::drawRect(x, y, 2, 2) gives
+static void playerBox(float x, float y)
+{
+    glColor3f(WALL_COLOR.redF(), WALL_COLOR.greenF(), WALL_COLOR.blueF());
+    glBegin(GL_LINE_LOOP);
+    glVertex2f(x + 0.5f, y + 0.5f);
+    glVertex2f(x + 2.5f, y + 0.5f);
+    glVertex2f(x + 2.5f, y + 2.5f);
+    glVertex2f(x + 0.5f, y + 2.5f);
+    glEnd();
+}
+
+void MinimapCache::drawGL(const Maze &maze, QPointF player, QSize view)
+{
+    refresh(maze, player);
+
+    // one texture per cached image, uploaded again only when it's redrawn
+    if (_textureDirty) {
+        if (!_texture)
+            glGenTextures(1, &_texture);
+        glBindTexture(GL_TEXTURE_2D, _texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _image.width(), _image.height(), 0,
+                     GL_BGRA, GL_UNSIGNED_BYTE, _image.constBits());
+        _textureDirty = false;
+    }
+
+    // pixels, y up from the bottom left corner
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, view.width(), 0, view.height(), -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA); // the image is premultiplied
+
+    if (!_windowed) {
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, _texture);
+        glColor4f(1, 1, 1, 1);
+        texturedQuad(0, 0, _image.width(), _image.height());
+        glDisable(GL_TEXTURE_2D);
+
+        playerBox(MINIMAP_PITCH*player.x() - 1 + MINIMAP_PITCH, MINIMAP_PITCH*player.y() - 1 + MINIMAP_PITCH);
+    } else {
+        const float center = 0.5f * MINIMAP_SIZE;
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(0, 0, MINIMAP_SIZE, MINIMAP_SIZE);
+        glColor4f(0.627f, 0.627f, 0.643f, 1); // Qt::gray
+        glRectf(0, 0, MINIMAP_SIZE, MINIMAP_SIZE);
+
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, _texture);
+        glColor4f(1, 1, 1, 1);
+        texturedQuad(center - (player.x() - _region.left()) * MINIMAP_PITCH,
+                     center - (player.y() - _region.top()) * MINIMAP_PITCH, _image.width(), _image.height());
+        glDisable(GL_TEXTURE_2D);
+        glDisable(GL_SCISSOR_TEST);
+
+        // the player stays in the middle
+        playerBox(center - 1, center - 1);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_BLEND);
+}
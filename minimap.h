@@ -0,0 +1,55 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include "maze.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QPointF>
+#include <QRect>
+#include <QSize>
+#include <qopengl.h>
+
+const int MINIMAP_PITCH = 20; // pixels per cell
+const int MINIMAP_SIZE = 250; // pixels per side of the backdrop
+const int MINIMAP_MAX_FULL = 1024; // largest maze image kept whole, in pixels
+const int MINIMAP_REGION = 64; // cells per side cached around the player
+
+// The maze part of the overlay, stroked once into an image and blitted every
+// frame. Mazes that fit in MINIMAP_MAX_FULL pixels are cached whole and drawn
+// like before; larger ones get a window the size of the backdrop that
+// scrolls with the player, cut from a cached region of the maze that is only
+// redrawn when the window runs off its edge.
+class MinimapCache
+{
+public:
+    MinimapCache();
+    // needs the GL context current once drawGL() has made the texture
+    ~MinimapCache();
+
+    // call whenever the maze or the widget size changes
+    void invalidate() { _valid = false; }
+
+    // player in cells, painter in widget coordinates of a viewHeight tall widget
+    void draw(QPainter &painter, const Maze &maze, QPointF player, int viewHeight);
+
+    // the same straight through GL in a view of the given size, with no
+    // QPainter and no heap allocation unless the image has to be redrawn;
+    // the GL context has to be current
+    void drawGL(const Maze &maze, QPointF player, QSize view);
+
+private:
+    void refresh(const Maze &maze, QPointF player);
+    void renderFull(const Maze &maze);
+    void renderRegion(const Maze &maze, QRect cells);
+    static void drawWalls(QPainter &painter, const Maze &maze, QRect cells, QPoint origin);
+
+    QImage _image;
+    bool _valid;
+    bool _windowed;
+    QRect _region; // cells in _image while windowed
+    GLuint _texture; // _image for drawGL(), 0 until the first
+    bool _textureDirty;
+};
+
+#endif // MINIMAP_H
@@ -0,0 +1,73 @@
+#include "mouselatch.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string.h>
+
+MouseLatch::MouseLatch() : _newest(0), _shown(0), _samples(0)
+{
+    memset(_moves, 0, sizeof(_moves));
+    memset(_latencies, 0, sizeof(_latencies));
+}
+
+quint32 MouseLatch::posted(QPoint delta, qint64 time)
+{
+    _newest++;
+    Move &move = _moves[_newest % MOUSE_LATCH_RING];
+    move.sequence = _newest;
+    move.delta = delta;
+    move.time = time;
+    return _newest;
+}
+
+// moves pushed out of the ring by newer ones are left out
+QPoint MouseLatch::pending(quint32 applied) const
+{
+    QPoint sum(0, 0);
+    const quint32 oldest = _newest > MOUSE_LATCH_RING ? _newest - MOUSE_LATCH_RING + 1 : 1;
+    for (quint32 sequence = std::max(applied + 1, oldest); sequence <= _newest; sequence++)
+        sum += _moves[sequence % MOUSE_LATCH_RING].delta;
+    return sum;
+}
+
+void MouseLatch::shown(quint32 sequence, qint64 time)
+{
+    const quint32 oldest = _newest > MOUSE_LATCH_RING ? _newest - MOUSE_LATCH_RING + 1 : 1;
+    for (quint32 s = std::max(_shown + 1, oldest); s <= sequence && s <= _newest; s++) {
+        _latencies[_samples % MOUSE_LATENCY_WINDOW] = time - _moves[s % MOUSE_LATCH_RING].time;
+        _samples++;
+    }
+    _shown = std::max(_shown, sequence);
+}
+
+MouseLatency MouseLatch::latency() const
+{
+    MouseLatency latency;
+    latency.samples = std::min(_samples, MOUSE_LATENCY_WINDOW);
+    latency.mean = 0.0;
+    latency.p99 = 0.0;
+    latency.worst = 0.0;
+    if (latency.samples == 0)
+        return latency;
+
+    qint64 sorted[MOUSE_LATENCY_WINDOW];
+    qint64 sum = 0;
+    for (int i = 0; i < latency.samples; i++) {
+        sorted[i] = _latencies[i];
+        sum += sorted[i];
+    }
+    std::sort(sorted, sorted + latency.samples);
+    latency.mean = sum * 1e-6 / latency.samples;
+    latency.p99 = sorted[std::min(latency.samples - 1, latency.samples * 99 / 100)] * 1e-6;
+    latency.worst = sorted[latency.samples - 1] * 1e-6;
+    return latency;
+}
+
+void MouseLatch::report() const
+{
+    const MouseLatency l = latency();
+    std::cout << std::fixed << std::setprecision(2)
+              << "mouse to screen over " << l.samples << " moves: mean " << l.mean << " ms, p99 " << l.p99
+              << ", max " << l.worst << std::endl;
+}
@@ -0,0 +1,62 @@
+#ifndef MOUSELATCH_H
+#define MOUSELATCH_H
+
+#include <QPoint>
+#include <QtGlobal>
+
+const int MOUSE_LATCH_RING = 256; // posted moves remembered, as many as the input queue holds
+const int MOUSE_LATENCY_WINDOW = 1024; // newest latencies the statistics cover
+
+// in ms, from a mouse move being posted to the swap of the first frame showing it
+struct MouseLatency
+{
+    int samples;
+    double mean;
+    double p99;
+    double worst;
+};
+
+// The GUI side of mouse look. Every move posted to the simulation is kept,
+// with when it was posted, until a published step has applied it: a frame
+// can add the moves still pending to the view it draws (late latching), and
+// the time each move took to reach the screen can be measured.
+class MouseLatch
+{
+public:
+    MouseLatch();
+
+    // the sequence number the next posted move gets
+    quint32 next() const { return _newest + 1; }
+
+    // a move that made it into the input queue, posted at time in ns;
+    // returns its sequence number, which next() said it would be
+    quint32 posted(QPoint delta, qint64 time);
+
+    // newest move posted, 0 before the first
+    quint32 newest() const { return _newest; }
+
+    // summed moves after applied, the newest a snapshot has applied
+    QPoint pending(quint32 applied) const;
+
+    // every move up to sequence was on screen at time
+    void shown(quint32 sequence, qint64 time);
+
+    MouseLatency latency() const;
+    void report() const;
+
+private:
+    struct Move
+    {
+        quint32 sequence;
+        QPoint delta;
+        qint64 time;
+    };
+
+    Move _moves[MOUSE_LATCH_RING]; // indexed by sequence
+    quint32 _newest;
+    quint32 _shown; // newest move on screen
+    qint64 _latencies[MOUSE_LATENCY_WINDOW]; // ns, ring indexed by sample
+    int _samples;
+};
+
+#endif // MOUSELATCH_H
@@ -0,0 +1,98 @@
+#include "options.h"
+
+#include <QCommandLineParser>
+
+#include <algorithm>
+#include <iostream>
+
+MazeOptions::MazeOptions() : physics("box2d"), chunks(0), hints(false), renderer("gl"), profile(false),
+    pacing("capped"), fps(100), frameStats(false),
+    lateLatch(false), latency(false)
+{
+}
+
+MazeOptions MazeOptions::parse(const QStringList &arguments)
+{
+    MazeOptions options;
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption physicsOption("physics", "Physics backend: box2d or grid.", "backend", options.physics);
+    parser.addOption(physicsOption);
+    QCommandLineOption chunksOption("chunks", "Stream an N x N chunk world instead of the single maze.", "N", QString::number(options.chunks));
+    parser.addOption(chunksOption);
+    QCommandLineOption mazeOption("maze", "Load the maze from a file instead of generating it.", "file");
+    parser.addOption(mazeOption);
+    QCommandLineOption saveMazeOption("save-maze", "Save the maze to a file at startup.", "file");
+    parser.addOption(saveMazeOption);
+    QCommandLineOption recordOption("record", "Record the session's input for replaying with maze-headless.", "file");
+    parser.addOption(recordOption);
+    QCommandLineOption rendererOption("renderer", "Renderer: gl, or software to raycast on the CPU. The window needs GL either way, maze-headless --render doesn't.", "renderer", options.renderer);
+    parser.addOption(rendererOption);
+    QCommandLineOption hintsOption("hints", "Mark the next cell on the way to the goal.");
+    parser.addOption(hintsOption);
+    QCommandLineOption profileOption("profile", "Graph where each frame's time goes.");
+    parser.addOption(profileOption);
+    QCommandLineOption profileTraceOption("profile-trace", "Write the last profiled zones as a Chrome trace on exit.", "file");
+    parser.addOption(profileTraceOption);
+    QCommandLineOption pacingOption("pacing", "When to paint: ondemand when something changed, vsync, or capped at --fps.", "mode", options.pacing);
+    parser.addOption(pacingOption);
+    QCommandLineOption fpsOption("fps", "Most frames a second with capped pacing.", "N", QString::number(options.fps));
+    parser.addOption(fpsOption);
+    QCommandLineOption frameStatsOption("frame-stats", "Print frame time statistics every few seconds.");
+    parser.addOption(frameStatsOption);
+    QCommandLineOption lateLatchOption("late-latch", "Read the mouse just before painting and show turns not simulated yet.");
+    parser.addOption(lateLatchOption);
+    QCommandLineOption latencyOption("latency", "Time mouse moves to the screen, finishing every frame on the GPU to do it.");
+    parser.addOption(latencyOption);
+    parser.process(arguments);
+
+    options.physics = parser.value(physicsOption);
+    if (options.physics != "box2d" && options.physics != "grid") {
+        std::cerr << "unknown physics backend, using box2d" << std::endl;
+        options.physics = "box2d";
+    }
+
+    options.renderer = parser.value(rendererOption);
+    if (options.renderer != "gl" && options.renderer != "software") {
+        std::cerr << "unknown renderer, using gl" << std::endl;
+        options.renderer = "gl";
+    }
+
+    options.pacing = parser.value(pacingOption);
+    if (options.pacing != "ondemand" && options.pacing != "vsync" && options.pacing != "capped") {
+        std::cerr << "unknown pacing, using capped" << std::endl;
+        options.pacing = "capped";
+    }
+    options.fps = parser.value(fpsOption).toInt();
+    if (options.fps < 1) {
+        std::cerr << "fps has to be at least 1, using 100" << std::endl;
+        options.fps = 100;
+    }
+    options.frameStats = parser.isSet(frameStatsOption);
+    options.lateLatch = parser.isSet(lateLatchOption);
+    options.latency = parser.isSet(latencyOption);
+
+    options.mazeFile = parser.value(mazeOption);
+    options.saveMazeFile = parser.value(saveMazeOption);
+    options.recordFile = parser.value(recordOption);
+    options.hints = parser.isSet(hintsOption);
+    options.profile = parser.isSet(profileOption);
+    options.profileTrace = parser.value(profileTraceOption);
+
+    options.chunks = std::max(0, parser.value(chunksOption).toInt());
+    if (options.chunks > 0 && options.physics != "box2d") {
+        std::cerr << "streamed worlds need box2d physics, using box2d" << std::endl;
+        options.physics = "box2d";
+    }
+    if (options.chunks > 0 && options.renderer != "gl") {
+        std::cerr << "streamed worlds are only drawn with gl, using gl" << std::endl;
+        options.renderer = "gl";
+    }
+    if (options.chunks > 0 && !options.recordFile.isEmpty()) {
+        std::cerr << "streamed worlds can't be replayed, not recording" << std::endl;
+        options.recordFile.clear();
+    }
+
+    return options;
+}
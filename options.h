@@ -0,0 +1,30 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <QString>
+#include <QStringList>
+
+// startup choices, read from the command line in main()
+struct MazeOptions
+{
+    MazeOptions();
+
+    QString physics; // "box2d" or "grid"
+    int chunks; // side of a streamed world in chunks, 0 for the single maze
+    QString mazeFile; // load the maze from here instead of generating it
+    QString saveMazeFile; // write the session's maze here at startup
+    QString recordFile; // log every step's input here, see inputlog.h
+    bool hints; // mark the next cell towards the goal (or the exit)
+    QString renderer; // "gl" or "software"
+    bool profile; // frame time graph next to the minimap
+    QString profileTrace; // Chrome trace of the last zones, written on exit
+    QString pacing; // "ondemand", "vsync" or "capped", see framescheduler.h
+    int fps; // most frames a second when capped
+    bool frameStats; // print frame time statistics every few seconds
+    bool lateLatch; // read the mouse just before painting and show moves not simulated yet
+    bool latency; // time mouse moves to the screen, printed every few seconds
+
+    static MazeOptions parse(const QStringList &arguments);
+};
+
+#endif // OPTIONS_H
@@ -0,0 +1,328 @@
+#include "pathindex.h"
+
+#include <algorithm>
+#include <functional>
+#include <stdlib.h>
+
+static const int EXITS[4] = { WALL_UP, WALL_DOWN, WALL_LEFT, WALL_RIGHT };
+
+static QPoint across(QPoint cell, int exit)
+{
+    switch (exit) {
+    case WALL_UP: return QPoint(cell.x(), cell.y() + 1);
+    case WALL_DOWN: return QPoint(cell.x(), cell.y() - 1);
+    case WALL_LEFT: return QPoint(cell.x() - 1, cell.y());
+    case WALL_RIGHT: return QPoint(cell.x() + 1, cell.y());
+    }
+    return cell;
+}
+
+PathIndex::PathIndex(const Maze &maze) : maze(maze), _stamp(0)
+{
+    _columns = (maze.width() + PATH_CLUSTER - 1) / PATH_CLUSTER;
+    _rows = (maze.height() + PATH_CLUSTER - 1) / PATH_CLUSTER;
+    _clusters.resize(_columns * _rows);
+    for (int i = 0; i < _clusters.size(); i++)
+        buildCluster(i);
+    numberNodes();
+}
+
+int PathIndex::clusterOf(QPoint cell) const
+{
+    return (cell.y() / PATH_CLUSTER) * _columns + cell.x() / PATH_CLUSTER;
+}
+
+QRect PathIndex::clusterRect(int cluster) const
+{
+    const int x = (cluster % _columns) * PATH_CLUSTER;
+    const int y = (cluster / _columns) * PATH_CLUSTER;
+    return QRect(x, y, std::min(PATH_CLUSTER, maze.width() - x), std::min(PATH_CLUSTER, maze.height() - y));
+}
+
+void PathIndex::searchCluster(QRect rect, QPoint source, quint16* distances) const
+{
+    const int width = rect.width();
+    const int cells = width * rect.height();
+    std::fill(distances, distances + cells, PATH_NO_ROUTE);
+
+    int queue[PATH_CLUSTER * PATH_CLUSTER];
+    int head = 0;
+    int tail = 0;
+    const int first = (source.y() - rect.top()) * width + source.x() - rect.left();
+    queue[tail++] = first;
+    distances[first] = 0;
+
+    while (head < tail) {
+        const int current = queue[head++];
+        const int x = current % width;
+        const int y = current / width;
+        const int walls = maze.row(rect.top() + y).mask(rect.left() + x);
+        const quint16 next = distances[current] + 1;
+
+        // only through walls that stay inside the rect
+        int neighbours[4];
+        int count = 0;
+        if (!(walls & WALL_RIGHT) && x + 1 < width)
+            neighbours[count++] = current + 1;
+        if (!(walls & WALL_LEFT) && x > 0)
+            neighbours[count++] = current - 1;
+        if (!(walls & WALL_UP) && y + 1 < rect.height())
+            neighbours[count++] = current + width;
+        if (!(walls & WALL_DOWN) && y > 0)
+            neighbours[count++] = current - width;
+
+        for (int i = 0; i < count; i++) {
+            if (distances[neighbours[i]] != PATH_NO_ROUTE)
+                continue;
+            distances[neighbours[i]] = next;
+            queue[tail++] = neighbours[i];
+        }
+    }
+}
+
+void PathIndex::buildCluster(int cluster)
+{
+    const QRect rect = clusterRect(cluster);
+    PathCluster &c = _clusters[cluster];
+    c.nodes.clear();
+
+    // openings across the four edges, but not out of the maze
+    for (int y = rect.top(); y <= rect.bottom(); y++) {
+        const WallRow walls = maze.row(y);
+        for (int x = rect.left(); x <= rect.right(); x++) {
+            if (x != rect.left() && x != rect.right() && y != rect.top() && y != rect.bottom())
+                continue;
+            const int mask = walls.mask(x);
+            int exits = 0;
+            if (x == rect.left() && x > 0 && !(mask & WALL_LEFT))
+                exits |= WALL_LEFT;
+            if (x == rect.right() && x < maze.width() - 1 && !(mask & WALL_RIGHT))
+                exits |= WALL_RIGHT;
+            if (y == rect.top() && y > 0 && !(mask & WALL_DOWN))
+                exits |= WALL_DOWN;
+            if (y == rect.bottom() && y < maze.height() - 1 && !(mask & WALL_UP))
+                exits |= WALL_UP;
+            if (exits) {
+                PathNode node = { QPoint(x, y), exits };
+                c.nodes.append(node);
+            }
+        }
+    }
+
+    const int n = c.nodes.size();
+    c.distances.resize(n * n);
+    quint16 distances[PATH_CLUSTER * PATH_CLUSTER];
+    for (int i = 0; i < n; i++) {
+        searchCluster(rect, c.nodes[i].cell, distances);
+        for (int j = 0; j < n; j++) {
+            const QPoint cell = c.nodes[j].cell - rect.topLeft();
+            c.distances[i * n + j] = distances[cell.y() * rect.width() + cell.x()];
+        }
+    }
+}
+
+void PathIndex::numberNodes()
+{
+    _nodeStart.resize(_clusters.size() + 1);
+    _nodeStart[0] = 0;
+    for (int i = 0; i < _clusters.size(); i++)
+        _nodeStart[i + 1] = _nodeStart[i] + _clusters[i].nodes.size();
+
+    const int total = _nodeStart.last();
+    _nodeCluster.resize(total);
+    for (int i = 0; i < _clusters.size(); i++)
+        std::fill(_nodeCluster.begin() + _nodeStart[i], _nodeCluster.begin() + _nodeStart[i + 1], i);
+
+    // two more for the ends of a query
+    _cost.resize(total + 2);
+    _parent.resize(total + 2);
+    _seen.fill(0, total + 2);
+    _stamp = 0;
+}
+
+int PathIndex::twin(int cluster, int node, int exit) const
+{
+    const QPoint cell = across(_clusters[cluster].nodes[node].cell, exit);
+    const int other = clusterOf(cell);
+    const QVector<PathNode> &nodes = _clusters[other].nodes;
+    for (int i = 0; i < nodes.size(); i++) {
+        if (nodes[i].cell == cell)
+            return _nodeStart[other] + i;
+    }
+    return -1;
+}
+
+QPoint PathIndex::nodeCell(int id, QPoint goal) const
+{
+    if (id >= _nodeStart.last())
+        return goal;
+    const int cluster = _nodeCluster[id];
+    return _clusters[cluster].nodes[id - _nodeStart[cluster]].cell;
+}
+
+static quint32 distance(QPoint a, QPoint b)
+{
+    return abs(a.x() - b.x()) + abs(a.y() - b.y());
+}
+
+// a cheaper way to node id; the manhattan distance left to the goal never
+// overestimates, so the first time the goal comes off the heap it's optimal
+void PathIndex::relax(int id, quint32 cost, int parent, QPoint goal)
+{
+    if (_seen[id] == _stamp && _cost[id] <= cost)
+        return;
+    _seen[id] = _stamp;
+    _cost[id] = cost;
+    _parent[id] = parent;
+    _open.append(qMakePair(cost + distance(nodeCell(id, goal), goal), id));
+    std::push_heap(_open.begin(), _open.end(), std::greater<QPair<quint32, int> >());
+}
+
+void PathIndex::update(QRect cells)
+{
+    // a wall on a cluster's edge changes the cluster on the other side too
+    const QRect changed = cells.adjusted(-1, -1, 1, 1) & QRect(0, 0, maze.width(), maze.height());
+    if (changed.isEmpty())
+        return;
+
+    for (int y = changed.top() / PATH_CLUSTER; y <= changed.bottom() / PATH_CLUSTER; y++) {
+        for (int x = changed.left() / PATH_CLUSTER; x <= changed.right() / PATH_CLUSTER; x++)
+            buildCluster(y * _columns + x);
+    }
+    numberNodes();
+}
+
+void PathIndex::appendLocalPath(QRect rect, QPoint a, QPoint b, QVector<QPoint> &path) const
+{
+    quint16 distances[PATH_CLUSTER * PATH_CLUSTER];
+    searchCluster(rect, b, distances);
+
+    // downhill from a to b
+    QPoint current = a;
+    while (current != b) {
+        const int walls = maze.row(current.y()).mask(current.x());
+        const QPoint here = current - rect.topLeft();
+        const quint16 d = distances[here.y() * rect.width() + here.x()];
+        for (int i = 0; i < 4; i++) {
+            if (walls & EXITS[i])
+                continue;
+            const QPoint next = across(current, EXITS[i]);
+            if (!rect.contains(next))
+                continue;
+            const QPoint there = next - rect.topLeft();
+            if (distances[there.y() * rect.width() + there.x()] == d - 1) {
+                current = next;
+                break;
+            }
+        }
+        path.append(current);
+    }
+}
+
+QVector<QPoint> PathIndex::path(QPoint from, QPoint to)
+{
+    QVector<QPoint> path;
+    const QRect bounds(0, 0, maze.width(), maze.height());
+    if (!bounds.contains(from) || !bounds.contains(to))
+        return path;
+    if (from == to) {
+        path.append(from);
+        return path;
+    }
+
+    if (++_stamp == 0) {
+        _seen.fill(0);
+        _stamp = 1;
+    }
+
+    const int START = _nodeStart.last();
+    const int GOAL = START + 1;
+    const int fromCluster = clusterOf(from);
+    const int toCluster = clusterOf(to);
+    const QRect fromRect = clusterRect(fromCluster);
+    const QRect toRect = clusterRect(toCluster);
+
+    // how the ends reach the nodes of their own clusters
+    quint16 fromDistances[PATH_CLUSTER * PATH_CLUSTER];
+    quint16 toDistances[PATH_CLUSTER * PATH_CLUSTER];
+    searchCluster(fromRect, from, fromDistances);
+    searchCluster(toRect, to, toDistances);
+
+    // A* over the nodes, see relax()
+    _open.resize(0);
+    const QVector<PathNode> &startNodes = _clusters[fromCluster].nodes;
+    for (int i = 0; i < startNodes.size(); i++) {
+        const QPoint cell = startNodes[i].cell - fromRect.topLeft();
+        const quint16 d = fromDistances[cell.y() * fromRect.width() + cell.x()];
+        if (d != PATH_NO_ROUTE)
+            relax(_nodeStart[fromCluster] + i, d, START, to);
+    }
+    if (fromCluster == toCluster) {
+        const QPoint cell = to - fromRect.topLeft();
+        const quint16 d = fromDistances[cell.y() * fromRect.width() + cell.x()];
+        if (d != PATH_NO_ROUTE)
+            relax(GOAL, d, START, to);
+    }
+
+    while (!_open.isEmpty()) {
+        std::pop_heap(_open.begin(), _open.end(), std::greater<QPair<quint32, int> >());
+        const QPair<quint32, int> entry = _open.last();
+        _open.removeLast();
+        const int id = entry.second;
+        if (id == GOAL)
+            break;
+        if (entry.first != _cost[id] + distance(nodeCell(id, to), to))
+            continue; // stale, reached cheaper since
+
+        const int cluster = _nodeCluster[id];
+        const PathCluster &c = _clusters[cluster];
+        const int node = id - _nodeStart[cluster];
+        const int n = c.nodes.size();
+        const quint32 cost = _cost[id];
+
+        for (int j = 0; j < n; j++) {
+            const quint16 d = c.distances[node * n + j];
+            if (j != node && d != PATH_NO_ROUTE)
+                relax(_nodeStart[cluster] + j, cost + d, id, to);
+        }
+        for (int i = 0; i < 4; i++) {
+            if (!(c.nodes[node].exits & EXITS[i]))
+                continue;
+            const int other = twin(cluster, node, EXITS[i]);
+            if (other >= 0)
+                relax(other, cost + 1, id, to);
+        }
+        if (cluster == toCluster) {
+            const QPoint cell = c.nodes[node].cell - toRect.topLeft();
+            const quint16 d = toDistances[cell.y() * toRect.width() + cell.x()];
+            if (d != PATH_NO_ROUTE)
+                relax(GOAL, cost + d, id, to);
+        }
+    }
+    if (_seen[GOAL] != _stamp)
+        return path;
+
+    QVector<int> route;
+    for (int id = GOAL; id != START; id = _parent[id])
+        route.append(id);
+    std::reverse(route.begin(), route.end());
+
+    // refine each hop: inside a cluster by a local search, across a border
+    // it's the one step
+    path.append(from);
+    int previous = START;
+    for (int i = 0; i < route.size(); i++) {
+        const int id = route[i];
+        const QPoint cell = nodeCell(id, to);
+        if (previous == START)
+            appendLocalPath(fromRect, from, cell, path);
+        else if (id == GOAL)
+            appendLocalPath(toRect, path.last(), to, path);
+        else if (_nodeCluster[id] == _nodeCluster[previous])
+            appendLocalPath(clusterRect(_nodeCluster[id]), path.last(), cell, path);
+        else
+            path.append(cell);
+        previous = id;
+    }
+    return path;
+}
@@ -0,0 +1,81 @@
+#ifndef PATHINDEX_H
+#define PATHINDEX_H
+
+#include "maze.h"
+
+#include <QVector>
+#include <QPair>
+#include <QPoint>
+#include <QRect>
+
+const int PATH_CLUSTER = 32; // cells per side of a cluster
+const quint16 PATH_NO_ROUTE = 0xffff;
+
+// a cell on a cluster's edge with an open wall into the next cluster
+struct PathNode
+{
+    QPoint cell;
+    int exits; // WALL_* bits of the walls open across the border
+};
+
+struct PathCluster
+{
+    QVector<PathNode> nodes;
+    // steps between every pair of nodes without leaving the cluster,
+    // nodes.size() squared, PATH_NO_ROUTE if there's no way
+    QVector<quint16> distances;
+};
+
+// Hierarchical path finding (HPA*) over a maze. The cells are cut into
+// PATH_CLUSTER sized clusters and every cell with an opening into another
+// cluster becomes a node of a small abstract graph, joined to its twin
+// across the border and to the other nodes of its cluster by precomputed
+// in-cluster distances. A query only searches the cells of the two end
+// clusters, then the abstract graph, then refines the clusters it passes.
+// Since every opening is a node the paths are as short as a full search.
+//
+// Queries share scratch space, so only run one at a time.
+class PathIndex
+{
+public:
+    explicit PathIndex(const Maze &maze);
+
+    // the cells from one to the other, both included; empty if there's no way
+    QVector<QPoint> path(QPoint from, QPoint to);
+
+    // rebuild the clusters around changed walls, call after Maze::setWall()
+    void update(QRect cells);
+
+    int clusterCount() const { return _clusters.size(); }
+    int nodeCount() const { return _nodeStart.last(); }
+
+private:
+    int clusterOf(QPoint cell) const;
+    QRect clusterRect(int cluster) const;
+    void buildCluster(int cluster);
+    void numberNodes();
+    int twin(int cluster, int node, int exit) const;
+    QPoint nodeCell(int id, QPoint goal) const;
+    void relax(int id, quint32 cost, int parent, QPoint goal);
+
+    // steps from source to every cell of rect, row-major in rect
+    void searchCluster(QRect rect, QPoint source, quint16* distances) const;
+    // from a to b inside rect, excluding a
+    void appendLocalPath(QRect rect, QPoint a, QPoint b, QVector<QPoint> &path) const;
+
+    const Maze &maze;
+    int _columns;
+    int _rows;
+    QVector<PathCluster> _clusters;
+    QVector<int> _nodeStart; // global number of each cluster's first node
+    QVector<int> _nodeCluster;
+
+    // per node scratch for path(), valid where _stamp matches
+    QVector<quint32> _cost;
+    QVector<int> _parent;
+    QVector<quint32> _seen;
+    quint32 _stamp;
+    QVector<QPair<quint32, int> > _open; // (estimate, node) min heap
+};
+
+#endif // PATHINDEX_H
@@ -0,0 +1,12 @@
+#include "physicsbackend.h"
+#include "box2dbackend.h"
+#include "gridcollider.h"
+
+PhysicsBackend* PhysicsBackend::create(const QString &name, const Maze &maze)
+{
+    if (name == "box2d")
+        return new Box2DBackend(maze);
+    if (name == "grid")
+        return new GridCollider(maze);
+    return 0;
+}
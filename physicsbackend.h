@@ -0,0 +1,44 @@
+#ifndef PHYSICSBACKEND_H
+#define PHYSICSBACKEND_H
+
+#include "maze.h"
+
+#include <QVector>
+#include <QString>
+#include <QPoint>
+
+#include <Box2D/Box2D.h>
+
+struct ChunkWalls;
+
+// What the game needs from a physics engine: a player disc steered by
+// setting its velocities, colliding with the walls of one maze.
+class PhysicsBackend
+{
+public:
+    virtual ~PhysicsBackend() {}
+
+    virtual void step(float seconds) = 0;
+
+    virtual b2Vec2 playerPosition() const = 0;
+    virtual float playerAngle() const = 0;
+    virtual b2Vec2 playerVelocity() const = 0;
+    virtual void setPlayerVelocity(b2Vec2 velocity) = 0;
+    virtual float playerAngularVelocity() const = 0;
+    virtual void setPlayerAngularVelocity(float velocity) = 0;
+    virtual void setPlayerTransform(b2Vec2 position, float angle) = 0;
+
+    // anything else that moves, at most max of them written to positions;
+    // returns how many were
+    virtual int propPositions(b2Vec2* positions, int max) const { Q_UNUSED(positions); Q_UNUSED(max); return 0; }
+
+    // static walls of a streamed world coming and going; false if the
+    // backend can only collide with the maze it was made for
+    virtual bool addChunk(const ChunkWalls &walls) { Q_UNUSED(walls); return false; }
+    virtual void removeChunk(QPoint chunk) { Q_UNUSED(chunk); }
+
+    // "box2d" or "grid", null for anything else
+    static PhysicsBackend* create(const QString &name, const Maze &maze);
+};
+
+#endif // PHYSICSBACKEND_H
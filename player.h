@@ -5,6 +5,24 @@
 
 enum { STRAFE_LEFT, STRAFE_RIGHT };
 
+const float PLAYER_RADIUS = 0.5f;
+
+// where the player is after a simulation step
+struct PlayerPose
+{
+    float x, y;
+    float angle;
+
+    static PlayerPose lerp(const PlayerPose &a, const PlayerPose &b, float t)
+    {
+        PlayerPose p;
+        p.x = a.x + (b.x - a.x) * t;
+        p.y = a.y + (b.y - a.y) * t;
+        p.angle = a.angle + (b.angle - a.angle) * t;
+        return p;
+    }
+};
+
 const float MAX_FORWARD_VELOCITY = 2.0f;
 const float MAX_BACKWARD_VELOCITY = 1.0f;
 const float MAX_STRAFE_VELOCITY = 2.0f;
@@ -0,0 +1,134 @@
+#include "portalvisibility.h"
+
+#include <math.h>
+
+static const float EPSILON = 1e-5f;
+
+static float cross(QVector2D a, QVector2D b)
+{
+    return a.x() * b.y() - a.y() * b.x();
+}
+
+// v lies within the wedge (inclusive)
+static bool inside(QVector2D right, QVector2D left, QVector2D v)
+{
+    return cross(right, v) >= -EPSILON && cross(v, left) >= -EPSILON;
+}
+
+static float distanceToCell(QVector2D eye, int x, int y)
+{
+    const float minX = CELL_WIDTH * x;
+    const float minY = CELL_WIDTH * y;
+    const float dx = eye.x() < minX ? minX - eye.x() : (eye.x() > minX + CELL_WIDTH ? eye.x() - minX - CELL_WIDTH : 0.0f);
+    const float dy = eye.y() < minY ? minY - eye.y() : (eye.y() > minY + CELL_WIDTH ? eye.y() - minY - CELL_WIDTH : 0.0f);
+    return sqrt(dx * dx + dy * dy);
+}
+
+PortalVisibility::PortalVisibility()
+{
+}
+
+// narrows wedge to what passes between the portal corners a and b (relative
+// to the eye), false if nothing does
+bool PortalVisibility::clip(const Wedge &wedge, QVector2D a, QVector2D b, Wedge &result)
+{
+    float side = cross(a, b);
+    if (fabs(side) < EPSILON) {
+        // the eye sits on the portal's line: standing in the doorway sees
+        // straight through, anywhere else the portal is edge on
+        if (QVector2D::dotProduct(a, b) > 0.0f)
+            return false;
+        result = wedge;
+        return true;
+    }
+    if (side < 0.0f)
+        qSwap(a, b);
+
+    result.all = false;
+    if (wedge.all) {
+        result.right = a;
+        result.left = b;
+        return true;
+    }
+
+    // two wedges narrower than half a turn overlap in a single wedge, bounded
+    // by whichever edge of each side lies inside the other one
+    if (inside(wedge.right, wedge.left, a))
+        result.right = a;
+    else if (inside(a, b, wedge.right))
+        result.right = wedge.right;
+    else
+        return false;
+
+    if (inside(wedge.right, wedge.left, b))
+        result.left = b;
+    else if (inside(a, b, wedge.left))
+        result.left = wedge.left;
+    else
+        return false;
+
+    return cross(result.right, result.left) > EPSILON;
+}
+
+const QVector<int>& PortalVisibility::update(const Maze &maze, QVector2D eye, float angle, float halfAngle, float farDistance)
+{
+    // keeping the capacity, so a frame doesn't allocate once warmed up
+    _cells.resize(0);
+    _stack.resize(0);
+
+    const int width = maze.width();
+    const int height = maze.height();
+    const int eyeX = (int)floor(eye.x() / CELL_WIDTH);
+    const int eyeY = (int)floor(eye.y() / CELL_WIDTH);
+    if (eyeX < 0 || eyeY < 0 || eyeX >= width || eyeY >= height)
+        return _cells;
+
+    Visit root;
+    root.cell = eyeY * width + eyeX;
+    root.from = -1;
+    root.wedge.all = halfAngle >= 0.5f * M_PI;
+    root.wedge.right = QVector2D(cos(angle - halfAngle), sin(angle - halfAngle));
+    root.wedge.left = QVector2D(cos(angle + halfAngle), sin(angle + halfAngle));
+    _stack.append(root);
+
+    while (!_stack.isEmpty()) {
+        const Visit visit = _stack.last();
+        _stack.removeLast();
+        _cells.append(visit.cell);
+
+        const int x = visit.cell % width;
+        const int y = visit.cell / width;
+        const int walls = maze.row(y).mask(x);
+
+        // the portal on each side of the cell as corners in world units
+        const float x0 = CELL_WIDTH * x - eye.x();
+        const float y0 = CELL_WIDTH * y - eye.y();
+        const float x1 = x0 + CELL_WIDTH;
+        const float y1 = y0 + CELL_WIDTH;
+        struct { int wall; int dx, dy; QVector2D a, b; } portals[4] = {
+            { WALL_UP, 0, 1, QVector2D(x0, y1), QVector2D(x1, y1) },
+            { WALL_DOWN, 0, -1, QVector2D(x0, y0), QVector2D(x1, y0) },
+            { WALL_LEFT, -1, 0, QVector2D(x0, y0), QVector2D(x0, y1) },
+            { WALL_RIGHT, 1, 0, QVector2D(x1, y0), QVector2D(x1, y1) }
+        };
+
+        for (int i = 0; i < 4; i++) {
+            if (walls & portals[i].wall)
+                continue;
+            const int nx = x + portals[i].dx;
+            const int ny = y + portals[i].dy;
+            const int next = ny * width + nx;
+            if (next == visit.from || distanceToCell(eye, nx, ny) > farDistance)
+                continue;
+
+            Visit child;
+            if (!clip(visit.wedge, portals[i].a, portals[i].b, child.wedge))
+                continue;
+            child.cell = next;
+            child.from = visit.cell;
+            _stack.append(child);
+        }
+    }
+
+    return _cells;
+}
@@ -0,0 +1,50 @@
+#ifndef PORTALVISIBILITY_H
+#define PORTALVISIBILITY_H
+
+#include "maze.h"
+
+#include <QVector>
+#include <QVector2D>
+
+// Which cells of a maze can be seen from a point, treating cells as rooms
+// and missing walls as portals. Starting in the eye's cell, the view wedge
+// is narrowed by every portal it passes through and a neighbour is only
+// entered while some of the wedge is left. A perfect maze has no loops, so
+// every cell is reached at most once and the work grows with what is
+// visible, not with the size of the maze.
+class PortalVisibility
+{
+public:
+    PortalVisibility();
+
+    // eye in world units, looking along angle with the given horizontal half
+    // angle in radians; anything of half angle pi/2 or wider sees all around.
+    // Cells further away than farDistance are left out.
+    const QVector<int>& update(const Maze &maze, QVector2D eye, float angle, float halfAngle, float farDistance);
+
+    // y * width + x of every visible cell from the last update
+    const QVector<int>& cells() const { return _cells; }
+
+private:
+    // directions from the eye bounding a view wedge, right is clockwise of left
+    struct Wedge
+    {
+        QVector2D right;
+        QVector2D left;
+        bool all; // no bounds at all
+    };
+
+    struct Visit
+    {
+        int cell;
+        int from; // the cell we came through, never walked back into
+        Wedge wedge;
+    };
+
+    static bool clip(const Wedge &wedge, QVector2D a, QVector2D b, Wedge &result);
+
+    QVector<int> _cells;
+    QVector<Visit> _stack;
+};
+
+#endif // PORTALVISIBILITY_H
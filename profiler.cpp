@@ -0,0 +1,183 @@
+#include "profiler.h"
+
+#include "allocationcounter.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QThreadStorage>
+
+#include <algorithm>
+#include <iostream>
+
+struct ProfileRing
+{
+    ProfileRing() : depth(0), count(0) {}
+
+    QString name;
+    int depth; // zones open right now
+    QAtomicInt count; // zones ever recorded, only the owning thread writes it
+    ProfileEvent events[PROFILER_RING];
+};
+
+// what the thread storage holds, so it doesn't delete the ring on thread
+// exit: its zones stay readable after the thread is gone. The ring only
+// comes with the thread's first zone, a name set before then waits here.
+struct ProfileThreadSlot
+{
+    ProfileThreadSlot() : ring(0), index(-1) {}
+
+    ProfileRing* ring;
+    int index;
+    QString name;
+};
+
+bool Profiler::_enabled = false;
+
+static QElapsedTimer profileClock;
+static QMutex ringsMutex; // held only to add or look up a ring
+static QVector<ProfileRing*> rings; // live as long as the process
+static QThreadStorage<ProfileThreadSlot> threadSlot;
+
+void Profiler::setEnabled(bool enabled)
+{
+    if (enabled && !profileClock.isValid())
+        profileClock.start();
+    _enabled = enabled;
+}
+
+qint64 Profiler::now()
+{
+    return profileClock.nsecsElapsed();
+}
+
+ProfileRing* Profiler::ring()
+{
+    ProfileThreadSlot &slot = threadSlot.localData();
+    if (!slot.ring) {
+        QMutexLocker locker(&ringsMutex);
+        slot.ring = new ProfileRing();
+        slot.index = rings.size();
+        slot.ring->name = slot.name.isEmpty() ? QString("thread %1").arg(slot.index) : slot.name;
+        rings.append(slot.ring);
+    }
+    return slot.ring;
+}
+
+// no ring for it yet, threads that never record stay free while disabled
+void Profiler::setThreadName(const char* name)
+{
+    ProfileThreadSlot &slot = threadSlot.localData();
+    slot.name = name;
+    if (slot.ring) {
+        QMutexLocker locker(&ringsMutex);
+        slot.ring->name = slot.name;
+    }
+}
+
+int Profiler::threadCount()
+{
+    QMutexLocker locker(&ringsMutex);
+    return rings.size();
+}
+
+QString Profiler::threadName(int thread)
+{
+    QMutexLocker locker(&ringsMutex);
+    return rings[thread]->name;
+}
+
+int Profiler::currentThread()
+{
+    ring();
+    return threadSlot.localData().index;
+}
+
+void ProfileZone::enter(const char* name)
+{
+    _ring = Profiler::ring();
+    _name = name;
+    _ring->depth++;
+    const AllocationCount allocated = AllocationCounter::thread();
+    _allocations = allocated.allocations;
+    _bytes = allocated.bytes;
+    _begin = Profiler::now();
+}
+
+void Profiler::record(ProfileRing* ring, const char* name, qint64 begin, quint64 allocations, quint64 bytes)
+{
+    const qint64 end = now();
+    const AllocationCount allocated = AllocationCounter::thread();
+    const int count = ring->count.loadAcquire(); // only we write it
+    ProfileEvent &event = ring->events[count & (PROFILER_RING - 1)];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    event.depth = --ring->depth;
+    event.allocations = allocated.allocations - allocations;
+    event.bytes = allocated.bytes - bytes;
+    ring->count.storeRelease(count + 1);
+}
+
+void Profiler::events(int thread, QVector<ProfileEvent> &events)
+{
+    ProfileRing* ring;
+    {
+        QMutexLocker locker(&ringsMutex);
+        ring = rings[thread];
+    }
+
+    const int count = ring->count.loadAcquire();
+    const int first = std::max(0, count - PROFILER_RING);
+    events.resize(count - first);
+    for (int i = first; i < count; i++)
+        events[i - first] = ring->events[i & (PROFILER_RING - 1)];
+
+    // the owner kept going while we copied; drop what it wrote over, and the
+    // slot of the zone it may be writing right now
+    const int overwritten = ring->count.loadAcquire() - PROFILER_RING + 1 - first;
+    if (overwritten > 0)
+        events.remove(0, std::min(overwritten, events.size()));
+}
+
+bool Profiler::writeChromeTrace(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        std::cerr << "can't write trace file " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    QTextStream out(&file);
+    out.setRealNumberNotation(QTextStream::FixedNotation);
+    out.setRealNumberPrecision(3);
+    out << "{\"traceEvents\":[\n";
+
+    // timestamps and durations in microseconds
+    QVector<ProfileEvent> zones;
+    for (int thread = 0; thread < threadCount(); thread++) {
+        out << (thread > 0 ? ",\n" : "")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+            << ",\"args\":{\"name\":\"" << threadName(thread) << "\"}}";
+
+        events(thread, zones);
+        for (int i = 0; i < zones.size(); i++) {
+            const ProfileEvent &zone = zones[i];
+            out << ",\n{\"name\":\"" << zone.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread
+                << ",\"ts\":" << zone.begin * 1e-3 << ",\"dur\":" << (zone.end - zone.begin) * 1e-3;
+            if (AllocationCounter::available())
+                out << ",\"args\":{\"allocations\":" << zone.allocations << ",\"bytes\":" << zone.bytes << "}";
+            out << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    out.flush();
+
+    if (out.status() != QTextStream::Ok) {
+        std::cerr << "failed writing trace file " << path.toStdString() << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QAtomicInt>
+#include <QString>
+#include <QVector>
+
+const int PROFILER_RING = 16384; // newest zones kept per thread, a power of two
+
+// one finished zone
+struct ProfileEvent
+{
+    const char* name; // a string literal
+    qint64 begin; // ns, Profiler::now()
+    qint64 end;
+    int depth; // zones open around it on its thread
+    quint64 allocations; // heap allocations inside it, zero unless counted
+    quint64 bytes; // and what they asked for
+};
+
+struct ProfileRing;
+
+// Scoped timing zones for finding where the frame goes. Every thread writes
+// its finished zones into a ring of its own with no locking; the GUI thread
+// reads them back for the overlay graph or a Chrome trace file. Until
+// setEnabled(true) a zone costs the test of one flag.
+class Profiler
+{
+public:
+    // before starting the threads that are to be profiled
+    static void setEnabled(bool enabled);
+    static bool enabled() { return _enabled; }
+
+    // ns since the profiler was enabled
+    static qint64 now();
+
+    // shown in traces instead of a number; cheap, the thread's ring is only
+    // made once it records a zone
+    static void setThreadName(const char* name);
+
+    // every thread that recorded a zone, in the order they started
+    static int threadCount();
+    static QString threadName(int thread);
+    static int currentThread();
+
+    // the thread's zones still in its ring, oldest first by end time,
+    // replacing what was in events
+    static void events(int thread, QVector<ProfileEvent> &events);
+
+    // everything still in the rings, in the Trace Event Format that
+    // chrome://tracing and Perfetto open
+    static bool writeChromeTrace(const QString &path);
+
+private:
+    friend class ProfileZone;
+    static ProfileRing* ring();
+    static void record(ProfileRing* ring, const char* name, qint64 begin, quint64 allocations, quint64 bytes);
+
+    static bool _enabled;
+};
+
+// times its own lifetime
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name) : _ring(0)
+    {
+        if (Profiler::enabled())
+            enter(name);
+    }
+    ~ProfileZone()
+    {
+        if (_ring)
+            Profiler::record(_ring, _name, _begin, _allocations, _bytes);
+    }
+
+private:
+    void enter(const char* name);
+
+    ProfileRing* _ring;
+    const char* _name;
+    qint64 _begin;
+    quint64 _allocations; // of the thread when entered
+    quint64 _bytes;
+};
+
+#endif // PROFILER_H
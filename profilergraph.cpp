@@ -0,0 +1,192 @@
+#include "profilergraph.h"
+
+#include "allocationcounter.h"
+
+#include <QColor>
+#include <QRectF>
+#include <QString>
+
+#include <algorithm>
+#include <string.h>
+
+static const char FRAME_ZONE[] = "frame";
+static const int LINE_HEIGHT = 14;
+
+// one per stage, grey for the rest of the frame
+static const QRgb STAGE_COLORS[PROFILER_GRAPH_STAGES + 1] = {
+    0x4e79a7, 0xf28e2b, 0xe15759, 0x76b7b2, 0x59a14f, 0xedc948, 0xb07aa1, 0xff9da7, 0x9c9c9c
+};
+
+ProfilerGraph::ProfilerGraph()
+{
+    memset(_bars, 0, sizeof(_bars));
+    memset(_allocations, 0, sizeof(_allocations));
+    memset(_bytes, 0, sizeof(_bytes));
+}
+
+// stages past the last colour count as the rest of the frame
+int ProfilerGraph::stage(const char* name)
+{
+    for (int i = 0; i < _stages.size(); i++) {
+        if (_stages[i] == name || strcmp(_stages[i], name) == 0)
+            return i;
+    }
+    if (_stages.size() == PROFILER_GRAPH_STAGES)
+        return PROFILER_GRAPH_STAGES;
+    _stages.append(name);
+    return _stages.size() - 1;
+}
+
+void ProfilerGraph::draw(QPainter &painter, QRect area)
+{
+    Profiler::events(Profiler::currentThread(), _events);
+
+    // a frame's stages finish before it does, so they come first
+    float times[PROFILER_GRAPH_STAGES + 1] = { 0 };
+    quint64 allocations[PROFILER_GRAPH_STAGES + 1] = { 0 };
+    quint64 bytes[PROFILER_GRAPH_STAGES + 1] = { 0 };
+    int frames = 0;
+    for (int i = 0; i < _events.size(); i++) {
+        const ProfileEvent &event = _events[i];
+        const float ms = (event.end - event.begin) * 1e-6f;
+        if (event.depth == 1) {
+            const int s = stage(event.name);
+            times[s] += ms;
+            allocations[s] += event.allocations;
+            bytes[s] += event.bytes;
+        } else if (event.depth == 0 && strcmp(event.name, FRAME_ZONE) == 0) {
+            float* bar = _bars[frames % PROFILER_GRAPH_FRAMES];
+            quint64* allocated = _allocations[frames % PROFILER_GRAPH_FRAMES];
+            quint64* allocatedBytes = _bytes[frames % PROFILER_GRAPH_FRAMES];
+            float rest = ms;
+            quint64 restAllocated = event.allocations;
+            quint64 restBytes = event.bytes;
+            for (int s = 0; s < PROFILER_GRAPH_STAGES; s++) {
+                bar[s] = times[s];
+                allocated[s] = allocations[s];
+                allocatedBytes[s] = bytes[s];
+                rest -= times[s];
+                restAllocated -= std::min(restAllocated, allocations[s]);
+                restBytes -= std::min(restBytes, bytes[s]);
+                times[s] = 0.0f;
+                allocations[s] = 0;
+                bytes[s] = 0;
+            }
+            bar[PROFILER_GRAPH_STAGES] = std::max(0.0f, rest);
+            allocated[PROFILER_GRAPH_STAGES] = restAllocated;
+            allocatedBytes[PROFILER_GRAPH_STAGES] = restBytes;
+            times[PROFILER_GRAPH_STAGES] = 0.0f;
+            allocations[PROFILER_GRAPH_STAGES] = 0;
+            bytes[PROFILER_GRAPH_STAGES] = 0;
+            frames++;
+        }
+    }
+    const int shown = std::min(frames, PROFILER_GRAPH_FRAMES);
+    const int first = frames - shown;
+
+    painter.save();
+    painter.setClipRect(area);
+    painter.fillRect(area, QColor(0, 0, 0, 160));
+
+    // twice the budget fits
+    const float scale = area.height() / (2.0f * PROFILER_GRAPH_BUDGET); // pixels per ms
+    float sums[PROFILER_GRAPH_STAGES + 1] = { 0 };
+    quint64 allocationSums[PROFILER_GRAPH_STAGES + 1] = { 0 };
+    quint64 byteSums[PROFILER_GRAPH_STAGES + 1] = { 0 };
+    float slowest = 0.0f;
+    for (int i = 0; i < shown; i++) {
+        const float* bar = _bars[(first + i) % PROFILER_GRAPH_FRAMES];
+        const quint64* allocated = _allocations[(first + i) % PROFILER_GRAPH_FRAMES];
+        const quint64* allocatedBytes = _bytes[(first + i) % PROFILER_GRAPH_FRAMES];
+        float y = area.bottom() + 1;
+        float frame = 0.0f;
+        for (int s = 0; s <= PROFILER_GRAPH_STAGES; s++) {
+            const float h = bar[s] * scale;
+            painter.fillRect(QRectF(area.left() + 2*i, y - h, 2, h), QColor(STAGE_COLORS[s]));
+            y -= h;
+            sums[s] += bar[s];
+            allocationSums[s] += allocated[s];
+            byteSums[s] += allocatedBytes[s];
+            frame += bar[s];
+        }
+        slowest = std::max(slowest, frame);
+    }
+
+    const int budgetY = area.bottom() - (int)(PROFILER_GRAPH_BUDGET * scale);
+    painter.setPen(QColor(255, 255, 255, 160));
+    painter.drawLine(area.left(), budgetY, area.left() + 2*PROFILER_GRAPH_FRAMES, budgetY);
+    painter.drawText(area.left() + 2, budgetY - 2, QString("%1 ms").arg(PROFILER_GRAPH_BUDGET));
+
+    // means over the frames in the graph
+    const int x = area.left() + 2*PROFILER_GRAPH_FRAMES + 8;
+    int y = area.top() + LINE_HEIGHT;
+    const float count = std::max(1, shown);
+    const bool counted = AllocationCounter::available();
+    float total = 0.0f;
+    quint64 allocationTotal = 0;
+    quint64 byteTotal = 0;
+    painter.setPen(Qt::white);
+    for (int i = 0; i <= _stages.size(); i++) {
+        const int s = i < _stages.size() ? i : PROFILER_GRAPH_STAGES;
+        const QString name = i < _stages.size() ? QString(_stages[i]) : QString("other");
+        painter.fillRect(x, y - 9, 9, 9, QColor(STAGE_COLORS[s]));
+        QString text = QString("%1 %2 ms").arg(name).arg(sums[s] / count, 0, 'f', 2);
+        if (counted)
+            text += QString(", %1 allocs (%2 bytes)").arg(allocationSums[s] / count, 0, 'f', 1).arg(byteSums[s] / count, 0, 'f', 0);
+        painter.drawText(x + 14, y, text);
+        total += sums[s];
+        allocationTotal += allocationSums[s];
+        byteTotal += byteSums[s];
+        y += LINE_HEIGHT;
+    }
+    QString text = QString("frame %1 ms, max %2").arg(total / count, 0, 'f', 2).arg(slowest, 0, 'f', 2);
+    if (counted)
+        text += QString(", %1 allocs (%2 bytes)").arg(allocationTotal / count, 0, 'f', 1).arg(byteTotal / count, 0, 'f', 0);
+    painter.drawText(x, y, text);
+    y += LINE_HEIGHT + 6;
+
+    drawThreads(painter, x, y);
+    painter.restore();
+}
+
+// every zone of the other threads that ended in the last second
+void ProfilerGraph::drawThreads(QPainter &painter, int x, int y)
+{
+    const int current = Profiler::currentThread();
+    const qint64 since = Profiler::now() - 1000000000LL;
+    for (int thread = 0; thread < Profiler::threadCount(); thread++) {
+        if (thread == current)
+            continue;
+        Profiler::events(thread, _events);
+
+        const char* names[PROFILER_GRAPH_STAGES];
+        qint64 totals[PROFILER_GRAPH_STAGES];
+        int counts[PROFILER_GRAPH_STAGES];
+        int zones = 0;
+        for (int i = 0; i < _events.size(); i++) {
+            const ProfileEvent &event = _events[i];
+            if (event.end < since)
+                continue;
+            int z = 0;
+            while (z < zones && strcmp(names[z], event.name) != 0)
+                z++;
+            if (z == zones) {
+                if (zones == PROFILER_GRAPH_STAGES)
+                    continue;
+                names[z] = event.name;
+                totals[z] = 0;
+                counts[z] = 0;
+                zones++;
+            }
+            totals[z] += event.end - event.begin;
+            counts[z]++;
+        }
+
+        const QString threadName = Profiler::threadName(thread);
+        for (int z = 0; z < zones; z++) {
+            painter.drawText(x, y, QString("%1 %2 %3 ms, %4/s").arg(threadName).arg(names[z])
+                             .arg(totals[z] * 1e-6 / counts[z], 0, 'f', 3).arg(counts[z]));
+            y += LINE_HEIGHT;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef PROFILERGRAPH_H
+#define PROFILERGRAPH_H
+
+#include "profiler.h"
+
+#include <QPainter>
+#include <QRect>
+#include <QVector>
+
+const int PROFILER_GRAPH_FRAMES = 120; // newest frames drawn, two pixels each
+const int PROFILER_GRAPH_STAGES = 8; // zones with a colour of their own
+const float PROFILER_GRAPH_BUDGET = 10.0f; // ms, the repaint interval
+const int PROFILER_GRAPH_WIDTH = 2*PROFILER_GRAPH_FRAMES + 340; // pixels with the legend
+
+// The frame time overlay: one stacked bar per painted frame, split into the
+// zones directly inside the "frame" zone of the painting thread, with the
+// budget marked. Beside it the mean of every stage, with its allocations and
+// their bytes when they are counted, and of the zones of the other threads
+// over the last second.
+class ProfilerGraph
+{
+public:
+    ProfilerGraph();
+
+    // from the thread that records the "frame" zones
+    void draw(QPainter &painter, QRect area);
+
+private:
+    int stage(const char* name);
+    void drawThreads(QPainter &painter, int x, int y);
+
+    QVector<ProfileEvent> _events;
+    QVector<const char*> _stages; // in the order they were first seen
+    float _bars[PROFILER_GRAPH_FRAMES][PROFILER_GRAPH_STAGES + 1]; // ms, the last is the rest of the frame
+    quint64 _allocations[PROFILER_GRAPH_FRAMES][PROFILER_GRAPH_STAGES + 1]; // heap allocations, the same way
+    quint64 _bytes[PROFILER_GRAPH_FRAMES][PROFILER_GRAPH_STAGES + 1];
+};
+
+#endif // PROFILERGRAPH_H
@@ -0,0 +1,40 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <QtGlobal>
+
+// small xorshift64* generator so a maze can be reproduced from its seed
+class Random
+{
+public:
+    explicit Random(quint64 seed) : _state(mix(seed)) {}
+
+    quint32 next()
+    {
+        _state ^= _state >> 12;
+        _state ^= _state << 25;
+        _state ^= _state >> 27;
+        return (quint32)((_state * 0x2545F4914F6CDD1DULL) >> 32);
+    }
+
+    // uniform integer in [0, n) without a modulo
+    int below(int n) { return (int)(((quint64)next() * (quint64)n) >> 32); }
+
+    // uniform float in [0, 1)
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+
+private:
+    // splitmix64 finalizer, keeps the state non-zero for any seed
+    static quint64 mix(quint64 seed)
+    {
+        quint64 z = seed + 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        z = z ^ (z >> 31);
+        return z ? z : 0x9E3779B97F4A7C15ULL;
+    }
+
+    quint64 _state;
+};
+
+#endif // RANDOM_H
@@ -0,0 +1,249 @@
+#include "raycaster.h"
+
+#include <math.h>
+
+// no fused multiply-adds in this file, or the scalar and avx2 walks round
+// differently wherever the compiler fuses one and not the other
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RAYCASTER_AVX2
+#include <immintrin.h>
+#endif
+
+// stands in for the crossing distance along an axis the ray doesn't move on
+static const float NEVER = 1e30f;
+
+WallRaycaster::WallRaycaster(const Maze &maze) : maze(maze)
+{
+}
+
+void WallRaycaster::castRay(float originX, float originY, float directionX, float directionY, float maxDistance, RayHit &hit) const
+{
+    // everything in cells from here on
+    const float px = originX / CELL_WIDTH;
+    const float py = originY / CELL_WIDTH;
+    int cx = (int)floorf(px);
+    int cy = (int)floorf(py);
+    hit.x = cx;
+    hit.y = cy;
+    hit.wall = 0;
+
+    if (cx < 0 || cy < 0 || cx >= maze.width() || cy >= maze.height()) {
+        hit.distance = 0.0f;
+        return;
+    }
+    const float length = sqrtf(directionX * directionX + directionY * directionY);
+    hit.distance = maxDistance;
+    if (length == 0.0f)
+        return;
+
+    const float ux = directionX / length;
+    const float uy = directionY / length;
+    const int stepX = ux > 0.0f ? 1 : -1;
+    const int stepY = uy > 0.0f ? 1 : -1;
+    const float deltaX = ux != 0.0f ? 1.0f / fabsf(ux) : NEVER;
+    const float deltaY = uy != 0.0f ? 1.0f / fabsf(uy) : NEVER;
+    float nextX = ux > 0.0f ? ((float)cx + 1.0f - px) * deltaX : (px - (float)cx) * deltaX;
+    float nextY = uy > 0.0f ? ((float)cy + 1.0f - py) * deltaY : (py - (float)cy) * deltaY;
+    const float limit = maxDistance / CELL_WIDTH;
+
+    // the halo keeps even a ray through an open border inside the grid
+    const WallGrid &walls = maze.walls();
+    for (;;) {
+        if (nextX < nextY) {
+            if (nextX > limit)
+                break;
+            if (walls.vertical(cx + (stepX > 0 ? 1 : 0), cy)) {
+                hit.distance = nextX * CELL_WIDTH;
+                hit.wall = stepX > 0 ? WALL_RIGHT : WALL_LEFT;
+                break;
+            }
+            cx += stepX;
+            nextX += deltaX;
+        } else {
+            if (nextY > limit)
+                break;
+            if (walls.horizontal(cx, cy + (stepY > 0 ? 1 : 0))) {
+                hit.distance = nextY * CELL_WIDTH;
+                hit.wall = stepY > 0 ? WALL_UP : WALL_DOWN;
+                break;
+            }
+            cy += stepY;
+            nextY += deltaY;
+        }
+    }
+    hit.x = cx;
+    hit.y = cy;
+}
+
+void WallRaycaster::castScalar(const RayBatch &rays, float maxDistance, RayHit* hits) const
+{
+    for (int i = 0; i < rays.count; i++)
+        castRay(rays.originX[i], rays.originY[i], rays.directionX[i], rays.directionY[i], maxDistance, hits[i]);
+}
+
+#ifdef RAYCASTER_AVX2
+
+// The scalar walk eight lanes wide. Each lane picks its axis, gathers the
+// 32 bit half of the wall word it crosses and either stops or steps on;
+// lanes that are done sit masked out until the whole group is.
+__attribute__((target("avx2")))
+static void castEight(const Maze &maze, const float* ox, const float* oy, const float* dx, const float* dy,
+                      float maxDistance, RayHit* hits)
+{
+    const __m256 cellWidth = _mm256_set1_ps(CELL_WIDTH);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 never = _mm256_set1_ps(NEVER);
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256i oneI = _mm256_set1_epi32(1);
+    const __m256i minusOne = _mm256_set1_epi32(-1);
+
+    const __m256 px = _mm256_div_ps(_mm256_loadu_ps(ox), cellWidth);
+    const __m256 py = _mm256_div_ps(_mm256_loadu_ps(oy), cellWidth);
+    const __m256 fx = _mm256_floor_ps(px);
+    const __m256 fy = _mm256_floor_ps(py);
+    __m256i cx = _mm256_cvttps_epi32(fx);
+    __m256i cy = _mm256_cvttps_epi32(fy);
+
+    const __m256i inside = _mm256_andnot_si256(
+        _mm256_or_si256(_mm256_or_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), cx), _mm256_cmpgt_epi32(_mm256_setzero_si256(), cy)),
+                        _mm256_or_si256(_mm256_cmpgt_epi32(cx, _mm256_set1_epi32(maze.width() - 1)), _mm256_cmpgt_epi32(cy, _mm256_set1_epi32(maze.height() - 1)))),
+        minusOne);
+
+    const __m256 dirX = _mm256_loadu_ps(dx);
+    const __m256 dirY = _mm256_loadu_ps(dy);
+    const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dirX, dirX), _mm256_mul_ps(dirY, dirY)));
+    const __m256i moving = _mm256_castps_si256(_mm256_cmp_ps(length, zero, _CMP_NEQ_OQ));
+
+    // still walking
+    __m256i active = _mm256_and_si256(inside, moving);
+
+    // a zero direction would divide by zero; those lanes are already done
+    const __m256 safeLength = _mm256_blendv_ps(one, length, _mm256_castsi256_ps(moving));
+    const __m256 ux = _mm256_div_ps(dirX, safeLength);
+    const __m256 uy = _mm256_div_ps(dirY, safeLength);
+    const __m256 positiveX = _mm256_cmp_ps(ux, zero, _CMP_GT_OQ);
+    const __m256 positiveY = _mm256_cmp_ps(uy, zero, _CMP_GT_OQ);
+    const __m256i stepX = _mm256_blendv_epi8(minusOne, oneI, _mm256_castps_si256(positiveX));
+    const __m256i stepY = _mm256_blendv_epi8(minusOne, oneI, _mm256_castps_si256(positiveY));
+
+    const __m256 flatX = _mm256_cmp_ps(ux, zero, _CMP_EQ_OQ);
+    const __m256 flatY = _mm256_cmp_ps(uy, zero, _CMP_EQ_OQ);
+    const __m256 deltaX = _mm256_blendv_ps(_mm256_div_ps(one, _mm256_andnot_ps(signBit, ux)), never, flatX);
+    const __m256 deltaY = _mm256_blendv_ps(_mm256_div_ps(one, _mm256_andnot_ps(signBit, uy)), never, flatY);
+    __m256 nextX = _mm256_mul_ps(_mm256_blendv_ps(_mm256_sub_ps(px, fx), _mm256_sub_ps(_mm256_add_ps(fx, one), px), positiveX), deltaX);
+    __m256 nextY = _mm256_mul_ps(_mm256_blendv_ps(_mm256_sub_ps(py, fy), _mm256_sub_ps(_mm256_add_ps(fy, one), py), positiveY), deltaY);
+    const __m256 limit = _mm256_set1_ps(maxDistance / CELL_WIDTH);
+
+    // outside lanes report 0, stuck ones the full distance
+    __m256 distance = _mm256_blendv_ps(zero, _mm256_set1_ps(maxDistance), _mm256_castsi256_ps(inside));
+    __m256i wall = _mm256_setzero_si256();
+
+    // the planes as 32 bit words: bit b of 64 bit word w is bit b & 31 of
+    // word 2w + b / 32
+    const WallGrid &walls = maze.walls();
+    const int* verticals = (const int*)walls.verticals();
+    const int* horizontals = (const int*)walls.horizontals();
+    const __m256i stride = _mm256_set1_epi32(walls.stride() * 2);
+    const __m256i sideX = _mm256_and_si256(_mm256_castps_si256(positiveX), oneI); // 1 moving right
+    const __m256i sideY = _mm256_and_si256(_mm256_castps_si256(positiveY), oneI);
+    const __m256i wallX = _mm256_blendv_epi8(_mm256_set1_epi32(WALL_LEFT), _mm256_set1_epi32(WALL_RIGHT), _mm256_castps_si256(positiveX));
+    const __m256i wallY = _mm256_blendv_epi8(_mm256_set1_epi32(WALL_DOWN), _mm256_set1_epi32(WALL_UP), _mm256_castps_si256(positiveY));
+    const __m256i mask31 = _mm256_set1_epi32(31);
+
+    while (!_mm256_testz_si256(active, active)) {
+        const __m256i useX = _mm256_castps_si256(_mm256_cmp_ps(nextX, nextY, _CMP_LT_OQ));
+        const __m256 t = _mm256_blendv_ps(nextY, nextX, _mm256_castsi256_ps(useX));
+
+        // past the limit, nothing to report
+        active = _mm256_andnot_si256(_mm256_castps_si256(_mm256_cmp_ps(t, limit, _CMP_GT_OQ)), active);
+
+        // vertical line cx + sideX of row cy, or horizontal line cy + sideY at column cx
+        const __m256i bitX = _mm256_add_epi32(_mm256_add_epi32(cx, sideX), oneI);
+        const __m256i indexX = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(cy, oneI), stride), _mm256_srli_epi32(bitX, 5));
+        const __m256i bitY = _mm256_add_epi32(cx, oneI);
+        const __m256i indexY = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_add_epi32(_mm256_add_epi32(cy, sideY), oneI), stride), _mm256_srli_epi32(bitY, 5));
+
+        const __m256i gatherX = _mm256_and_si256(active, useX);
+        const __m256i gatherY = _mm256_andnot_si256(useX, active);
+        __m256i words = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), verticals, indexX, gatherX, 4);
+        words = _mm256_mask_i32gather_epi32(words, horizontals, indexY, gatherY, 4);
+        const __m256i shift = _mm256_blendv_epi8(_mm256_and_si256(bitY, mask31), _mm256_and_si256(bitX, mask31), useX);
+        const __m256i blocked = _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(_mm256_srlv_epi32(words, shift), oneI), oneI), active);
+
+        distance = _mm256_blendv_ps(distance, _mm256_mul_ps(t, cellWidth), _mm256_castsi256_ps(blocked));
+        wall = _mm256_blendv_epi8(wall, _mm256_blendv_epi8(wallY, wallX, useX), blocked);
+        active = _mm256_andnot_si256(blocked, active);
+
+        // everything still going steps on along its axis
+        const __m256i stepsX = _mm256_and_si256(active, useX);
+        const __m256i stepsY = _mm256_andnot_si256(useX, active);
+        cx = _mm256_add_epi32(cx, _mm256_and_si256(stepX, stepsX));
+        cy = _mm256_add_epi32(cy, _mm256_and_si256(stepY, stepsY));
+        nextX = _mm256_add_ps(nextX, _mm256_and_ps(deltaX, _mm256_castsi256_ps(stepsX)));
+        nextY = _mm256_add_ps(nextY, _mm256_and_ps(deltaY, _mm256_castsi256_ps(stepsY)));
+    }
+
+    float distances[8];
+    int wallSides[8], xs[8], ys[8];
+    _mm256_storeu_ps(distances, distance);
+    _mm256_storeu_si256((__m256i*)wallSides, wall);
+    _mm256_storeu_si256((__m256i*)xs, cx);
+    _mm256_storeu_si256((__m256i*)ys, cy);
+    for (int i = 0; i < 8; i++) {
+        hits[i].distance = distances[i];
+        hits[i].wall = wallSides[i];
+        hits[i].x = xs[i];
+        hits[i].y = ys[i];
+    }
+}
+
+bool WallRaycaster::vectorized()
+{
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+#else
+
+bool WallRaycaster::vectorized()
+{
+    return false;
+}
+
+#endif
+
+void WallRaycaster::cast(const RayBatch &rays, float maxDistance, RayHit* hits) const
+{
+    int i = 0;
+#ifdef RAYCASTER_AVX2
+    if (vectorized()) {
+        for (; i + 8 <= rays.count; i += 8)
+            castEight(maze, rays.originX + i, rays.originY + i, rays.directionX + i, rays.directionY + i, maxDistance, hits + i);
+    }
+#endif
+    for (; i < rays.count; i++)
+        castRay(rays.originX[i], rays.originY[i], rays.directionX[i], rays.directionY[i], maxDistance, hits[i]);
+}
+
+bool WallRaycaster::visible(QPointF from, QPointF to) const
+{
+    const QPointF d = to - from;
+    const float length = sqrtf(d.x() * d.x() + d.y() * d.y());
+    RayHit hit;
+    castRay(from.x(), from.y(), d.x(), d.y(), length, hit);
+    return hit.wall == 0 && hit.distance >= length;
+}
+
+float WallRaycaster::wallDistance(QPointF origin, QPointF direction, float maxDistance) const
+{
+    RayHit hit;
+    castRay(origin.x(), origin.y(), direction.x(), direction.y(), maxDistance, hit);
+    return hit.distance;
+}
@@ -0,0 +1,55 @@
+#ifndef RAYCASTER_H
+#define RAYCASTER_H
+
+#include "maze.h"
+
+#include <QPointF>
+
+// rays as separate arrays of world coordinates, so eight load at once;
+// directions don't need to be normalized
+struct RayBatch
+{
+    const float* originX;
+    const float* originY;
+    const float* directionX;
+    const float* directionY;
+    int count;
+};
+
+struct RayHit
+{
+    float distance; // world units to the wall, maxDistance if none
+    int wall; // WALL_* side of cell that was hit, 0 if none
+    int x, y; // cell the ray was in when it hit
+};
+
+// Line of sight straight on the packed walls of a maze: every ray steps
+// from cell to cell (DDA) and tests one wall bit per crossing, so a batch
+// never touches Box2D. Where the CPU has AVX2 eight rays go through the
+// grid together, each lane gathering its own wall word; the scalar walk
+// handles the rest and anything else. Both give the same results;
+// raycaster.cpp turns off FMA contraction for that.
+//
+// Rays starting outside the maze hit at once, distance 0 and no wall.
+class WallRaycaster
+{
+public:
+    explicit WallRaycaster(const Maze &maze);
+
+    void cast(const RayBatch &rays, float maxDistance, RayHit* hits) const;
+    void castScalar(const RayBatch &rays, float maxDistance, RayHit* hits) const;
+
+    // nothing between the two points
+    bool visible(QPointF from, QPointF to) const;
+    float wallDistance(QPointF origin, QPointF direction, float maxDistance) const;
+
+    // true when cast() takes the AVX2 path
+    static bool vectorized();
+
+private:
+    void castRay(float originX, float originY, float directionX, float directionY, float maxDistance, RayHit &hit) const;
+
+    const Maze &maze;
+};
+
+#endif // RAYCASTER_H
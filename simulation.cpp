@@ -0,0 +1,300 @@
+#include "simulation.h"
+#include "bulletworld.h"
+#include "chunkwalls.h"
+#include "distancefield.h"
+#include "inputlog.h"
+#include "profiler.h"
+
+#include <QVector3D>
+
+#include <algorithm>
+#include <iostream>
+#include <math.h>
+
+b2Vec2 dir(float angle)
+{
+    return b2Vec2(cos(angle), sin(angle));
+}
+
+static QVector3D to3D(b2Vec2 v) {
+    return QVector3D((float)(v.x), (float)(v.y), 0.0f);
+}
+
+Simulation::Simulation(const Maze &maze, const QString &physicsName) : maze(maze)
+{
+    init(physicsName);
+
+    // the goal goes as far from the start as the maze allows
+    _goal = QPoint(2, 0);
+    _start = QPoint(0, 0);
+    if (maze.width() > 0 && maze.height() > 0) {
+        _startField = new DistanceField(maze, _start);
+        _goal = _startField->farthest();
+        _goalField = new DistanceField(maze, _goal);
+    }
+}
+
+Simulation::Simulation(const Maze &maze, const QString &physicsName, QPoint start, QPoint goal,
+                       const quint32* startDistances) : maze(maze)
+{
+    init(physicsName);
+
+    _start = start;
+    _goal = goal;
+    // a streamed world has no maze of its own to search
+    if (maze.width() > 0 && maze.height() > 0) {
+        if (startDistances)
+            _startField = new DistanceField(maze, _start, startDistances);
+        else
+            _startField = new DistanceField(maze, _start);
+        _goalField = new DistanceField(maze, _goal);
+    }
+}
+
+// everything but the endpoints and their fields
+void Simulation::init(const QString &physicsName)
+{
+    physics = PhysicsBackend::create(physicsName, maze);
+
+    // nothing uses bullet yet, see bullet()
+    bulletWorld = 0;
+    chunkEvents = 0;
+    recorder = 0;
+
+    keys = 0;
+    mouseSequence = 0;
+    _mouseApplied = 0;
+    _mouseTurn = 0.0f;
+    _upDownAngle = 0.0f;
+
+    _startField = 0;
+    _goalField = 0;
+    _gameMode = GAME_SEARCHING;
+    _tick = 0;
+}
+
+Simulation::~Simulation()
+{
+    delete _goalField;
+    delete _startField;
+    delete bulletWorld;
+    delete physics;
+}
+
+BulletWorld* Simulation::bullet()
+{
+    if (!bulletWorld)
+        bulletWorld = new BulletWorld();
+    return bulletWorld;
+}
+
+QPoint Simulation::hint() const
+{
+    const b2Vec2 p = physics->playerPosition();
+    const QPoint cell(p.x / CELL_WIDTH, p.y / CELL_WIDTH);
+
+    // the way out is the way back to the start, so fleeing reuses its field
+    const DistanceField* field = _gameMode == GAME_FLEEING ? _startField : _goalField;
+    return field ? field->nextStep(cell) : cell;
+}
+
+void Simulation::handle(const InputEvent &event)
+{
+    switch (event.type) {
+    case InputEvent::KEY_DOWN:
+        // forward and back don't override each other
+        if (event.key == KEY_FORWARD && (keys & KEY_BACK))
+            break;
+        if (event.key == KEY_BACK && (keys & KEY_FORWARD))
+            break;
+        keys |= event.key;
+        break;
+    case InputEvent::KEY_UP:
+        keys &= ~event.key;
+        break;
+    case InputEvent::MOUSE_MOVE:
+        // however many arrive between two steps, the next applies them all
+        mouseDelta += QPoint(event.dx, event.dy);
+        mouseSequence = event.sequence;
+        break;
+    }
+}
+
+void Simulation::setInput(int keys, QPoint mouse)
+{
+    this->keys = keys;
+    mouseDelta = mouse;
+}
+
+PlayerPose Simulation::pose() const
+{
+    PlayerPose pose;
+    pose.x = physics->playerPosition().x;
+    pose.y = physics->playerPosition().y;
+    pose.angle = physics->playerAngle();
+    return pose;
+}
+
+void Simulation::updateChunks()
+{
+    ProfileZone zone("chunks");
+    QVector<ChunkEvent> events;
+    chunkEvents->take(events);
+    for (int i = 0; i < events.size(); i++) {
+        if (events[i].added)
+            physics->addChunk(events[i].walls);
+        else
+            physics->removeChunk(events[i].walls.chunk);
+    }
+}
+
+void Simulation::step(float seconds)
+{
+    ProfileZone zone("step");
+
+    if (chunkEvents)
+        updateChunks();
+
+    if (recorder)
+        recorder->record(_tick, keys, mouseDelta);
+
+    _mouseTurn = 0.0f;
+    if (_gameMode == GAME_MINIGAME)
+        updateMiniGame();
+    else
+        updateWorld(seconds);
+    mouseDelta = QPoint(0, 0);
+    _mouseApplied = mouseSequence;
+
+    // see if at end
+    const b2Vec2 p = physics->playerPosition();
+    QPoint currentCell(p.x / CELL_WIDTH, p.y / CELL_WIDTH);
+    if (currentCell == _goal && _gameMode == GAME_SEARCHING) {
+        _gameMode = GAME_MINIGAME;
+    }
+
+    _tick++;
+}
+
+void Simulation::fillSnapshot(SimulationSnapshot &snapshot) const
+{
+    snapshot.current = pose();
+    snapshot.upDownAngle = _upDownAngle;
+    snapshot.gameMode = _gameMode;
+    snapshot.hint = hint();
+    snapshot.mouseSequence = _mouseApplied;
+    snapshot.mouseTurn = _mouseTurn;
+    snapshot.tick = _tick;
+
+    snapshot.propCount = physics->propPositions(snapshot.props, MAX_PROPS);
+}
+
+void Simulation::updateMiniGame()
+{
+
+}
+
+void Simulation::updateWorld(float elapsedSeconds)
+{
+    ProfileZone zone("updateWorld");
+
+    if (bulletWorld) {
+        ProfileZone bulletZone("bullet");
+        bulletWorld->step(elapsedSeconds);
+    }
+    {
+        ProfileZone physicsZone("physics");
+        physics->step(elapsedSeconds);
+    }
+
+    float currentAngle = physics->playerAngle();
+
+    b2Vec2 lookDir = dir(currentAngle);
+    if (keys & KEY_FORWARD) {
+        b2Vec2 v = physics->playerVelocity();
+        b2Vec2 newV = ACCELERATION * elapsedSeconds * lookDir + v;
+        float l = std::min(MAX_FORWARD_VELOCITY, newV.Length());
+        newV.Normalize();
+        newV *= l;
+        physics->setPlayerVelocity(newV);
+    } else if (keys & KEY_BACK) {
+        b2Vec2 v = physics->playerVelocity();
+        b2Vec2 newV = -ACCELERATION * elapsedSeconds * lookDir + v;
+        float l = std::min(MAX_BACKWARD_VELOCITY, newV.Length());
+        newV.Normalize();
+        newV *= l;
+        physics->setPlayerVelocity(newV);
+    } else { // slow down
+        b2Vec2 v = physics->playerVelocity();
+
+        // adjust velocity to be where player is facing
+        float l = v.Length();
+        if (l > 0) {
+            l -= elapsedSeconds * ACCELERATION;
+            l = std::max(0.0f, l);
+        } else {
+            l += elapsedSeconds * ACCELERATION;
+            l = std::min(0.0f, l);
+        }
+        v.Normalize();
+        v *= l;
+        physics->setPlayerVelocity(v);
+    }
+
+    if (keys & KEY_STRAFE_LEFT) {
+        QVector3D lookDir3D = to3D(lookDir);
+        QVector3D leftDir = QVector3D::crossProduct(lookDir3D, QVector3D(0,0,-1));
+        leftDir.normalize();
+
+        b2Vec2 v = physics->playerVelocity();
+        float currentLeftV = QVector3D::dotProduct(leftDir, to3D(v)) / v.Length();
+        if (v.Length() < 0.001f || currentLeftV < MAX_STRAFE_VELOCITY) { // can strafe left
+            b2Vec2 newV = ACCELERATION * elapsedSeconds * b2Vec2(leftDir.x(), leftDir.y()) + v;
+            physics->setPlayerVelocity(newV);
+        }
+    } else if (keys & KEY_STRAFE_RIGHT) {
+        QVector3D lookDir3D = to3D(lookDir);
+        QVector3D rightDir = QVector3D::crossProduct(lookDir3D, QVector3D(0,0,1));
+        rightDir.normalize();
+
+        b2Vec2 v = physics->playerVelocity();
+        float currentRightV = QVector3D::dotProduct(rightDir, to3D(v)) / v.Length();
+        if (v.Length() < 0.001f || currentRightV < MAX_STRAFE_VELOCITY) { // can strafe right
+            b2Vec2 newV = ACCELERATION * elapsedSeconds * b2Vec2(rightDir.x(), rightDir.y()) + v;
+            physics->setPlayerVelocity(newV);
+        }
+    }
+
+    const bool left = keys & KEY_TURN_LEFT;
+    const bool right = keys & KEY_TURN_RIGHT;
+    if (left && !right) {
+        float v = physics->playerAngularVelocity();
+        v += elapsedSeconds * TURN_ACCELERATION;
+        v = std::min(MAX_TURN_VELOCITY, v);
+        physics->setPlayerAngularVelocity(v);
+    } else if (right && !left) {
+        float v = physics->playerAngularVelocity();
+        v -= elapsedSeconds * TURN_ACCELERATION;
+        v = std::max(-MAX_TURN_VELOCITY, v);
+        physics->setPlayerAngularVelocity(v);
+    } else { // slow down
+        float v = physics->playerAngularVelocity();
+        if (v > 0) {
+            v -= elapsedSeconds * TURN_ACCELERATION;
+            v = std::max(0.0f, v);
+            physics->setPlayerAngularVelocity(v);
+        } else {
+            v += elapsedSeconds * TURN_ACCELERATION;
+            v = std::min(0.0f, v);
+            physics->setPlayerAngularVelocity(v);
+        }
+    }
+
+    if (mouseDelta.x() != 0) {
+        _mouseTurn = mouseTurn(mouseDelta.x());
+        physics->setPlayerTransform(physics->playerPosition(), physics->playerAngle() + _mouseTurn);
+    }
+    if (mouseDelta.y() != 0) {
+        _upDownAngle += mouseTilt(mouseDelta.y());
+    }
+}
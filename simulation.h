@@ -0,0 +1,134 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "maze.h"
+#include "player.h"
+#include "physicsbackend.h"
+
+#include <QPoint>
+#include <QString>
+
+enum { GAME_SEARCHING, GAME_MINIGAME, GAME_FLEEING };
+
+// player controls, one bit each while held
+enum {
+    KEY_FORWARD = 1,
+    KEY_BACK = 2,
+    KEY_TURN_LEFT = 4,
+    KEY_TURN_RIGHT = 8,
+    KEY_STRAFE_LEFT = 16,
+    KEY_STRAFE_RIGHT = 32
+};
+
+struct InputEvent
+{
+    enum { KEY_DOWN, KEY_UP, MOUSE_MOVE };
+
+    int type;
+    int key; // KEY_*
+    int dx, dy; // mouse
+    quint32 sequence; // of a mouse move, counting up from 1
+};
+
+const float MOUSE_RADIANS = 0.0005f; // turned or tilted per pixel of mouse movement
+
+class BulletWorld;
+class ChunkEventQueue;
+class DistanceField;
+class InputRecorder;
+
+const int MAX_PROPS = 4;
+
+// everything the renderer needs from one simulation step
+struct SimulationSnapshot
+{
+    PlayerPose previous;
+    PlayerPose current;
+    float upDownAngle;
+    int gameMode;
+    b2Vec2 props[MAX_PROPS];
+    int propCount;
+    QPoint hint; // next cell towards the goal, or the exit once fleeing
+    quint32 mouseSequence; // newest mouse move applied, 0 for none yet
+    float mouseTurn; // radians of current.angle the last step's mouse moves turned
+    quint64 tick;
+    qint64 stepTime; // ns, when the current pose was reached
+};
+
+b2Vec2 dir(float angle);
+
+// The game world without any window: the physics, the movement rules for
+// the held keys and mouse, and the goal/mode transitions. Advanced one fixed
+// step at a time by whoever owns it.
+class Simulation
+{
+public:
+    // the goal as far from the start at (0,0) as the maze allows
+    Simulation(const Maze &maze, const QString &physicsName);
+    // known endpoints, with the distances from start if they were saved with
+    // the maze, or null to compute them; each field is searched at most once
+    Simulation(const Maze &maze, const QString &physicsName, QPoint start, QPoint goal,
+               const quint32* startDistances = 0);
+    ~Simulation();
+
+    void handle(const InputEvent &event);
+    void step(float seconds);
+
+    // the input a step will see, all at once; for replaying a log
+    void setInput(int keys, QPoint mouse);
+
+    // gets the input of every step from now on, not owned
+    void setRecorder(InputRecorder* recorder) { this->recorder = recorder; }
+
+    // what a mouse movement does to the view, in radians
+    static float mouseTurn(int dx) { return dx * -MOUSE_RADIANS; }
+    static float mouseTilt(int dy) { return dy * MOUSE_RADIANS; }
+
+    PlayerPose pose() const;
+    float upDownAngle() const { return _upDownAngle; }
+    int gameMode() const { return _gameMode; }
+    QPoint goal() const { return _goal; }
+    QPoint start() const { return _start; }
+    QPoint hint() const;
+    quint64 tick() const { return _tick; }
+
+    void fillSnapshot(SimulationSnapshot &snapshot) const;
+
+    // walls of a streamed world, applied to the physics before every step
+    void setChunkEvents(ChunkEventQueue* events) { chunkEvents = events; }
+
+    // created the first time something asks for it
+    BulletWorld* bullet();
+
+    // steps to every cell from the start and the goal, null in streamed worlds
+    const DistanceField* startField() const { return _startField; }
+    const DistanceField* goalField() const { return _goalField; }
+
+private:
+    void updateMiniGame();
+    void updateWorld(float elapsedSeconds);
+    void updateChunks();
+    void init(const QString &physicsName);
+
+    const Maze &maze;
+    PhysicsBackend* physics;
+    BulletWorld* bulletWorld;
+    ChunkEventQueue* chunkEvents;
+    InputRecorder* recorder;
+
+    int keys; // KEY_* bits
+    QPoint mouseDelta; // every mouse move since the last step, summed
+    quint32 mouseSequence; // of the newest of them
+    quint32 _mouseApplied; // sequence of the newest a step applied
+    float _mouseTurn; // by the last step
+    float _upDownAngle;
+
+    QPoint _goal;
+    QPoint _start;
+    DistanceField* _startField;
+    DistanceField* _goalField;
+    int _gameMode;
+    quint64 _tick;
+};
+
+#endif // SIMULATION_H
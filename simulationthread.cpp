@@ -0,0 +1,90 @@
+#include "simulationthread.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+SimulationThread::SimulationThread(Simulation* simulation, QObject *parent) :
+    QThread(parent),
+    simulation(simulation),
+    unseen(0),
+    stopping(0)
+{
+    clock.start();
+
+    // something to draw before the first step
+    SimulationSnapshot &first = snapshots.back();
+    simulation->fillSnapshot(first);
+    first.previous = first.current;
+    first.stepTime = clock.nsecsElapsed();
+    published = first;
+    snapshots.publish();
+}
+
+// everything that's drawn, leaving out the tick and the time
+static bool looksSame(const SimulationSnapshot &a, const SimulationSnapshot &b)
+{
+    if (a.previous.x != b.previous.x || a.previous.y != b.previous.y || a.previous.angle != b.previous.angle ||
+        a.current.x != b.current.x || a.current.y != b.current.y || a.current.angle != b.current.angle ||
+        a.upDownAngle != b.upDownAngle || a.gameMode != b.gameMode || a.hint != b.hint ||
+        a.propCount != b.propCount)
+        return false;
+    for (int i = 0; i < a.propCount; i++) {
+        if (a.props[i].x != b.props[i].x || a.props[i].y != b.props[i].y)
+            return false;
+    }
+    return true;
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+    wait();
+}
+
+void SimulationThread::stop()
+{
+    stopping.storeRelease(1);
+}
+
+void SimulationThread::run()
+{
+    Profiler::setThreadName("simulation");
+    const qint64 stepNs = (qint64)(timestep.step() * 1e9);
+    PlayerPose pose = simulation->pose();
+    qint64 last = clock.nsecsElapsed();
+
+    while (!stopping.loadAcquire()) {
+        InputEvent event;
+        while (input.pop(event))
+            simulation->handle(event);
+
+        const qint64 now = clock.nsecsElapsed();
+        const int steps = timestep.advance((now - last) * 1e-9);
+        last = now;
+
+        if (steps > 0) {
+            PlayerPose previous = pose;
+            for (int i = 0; i < steps; i++) {
+                previous = pose;
+                simulation->step((float)timestep.step());
+                pose = simulation->pose();
+            }
+
+            SimulationSnapshot &snapshot = snapshots.back();
+            simulation->fillSnapshot(snapshot);
+            snapshot.previous = previous;
+            // the leftover time in the accumulator already happened
+            snapshot.stepTime = now - (qint64)(timestep.alpha() * stepNs);
+            const bool change = !looksSame(snapshot, published);
+            published = snapshot;
+            snapshots.publish();
+
+            if (change && unseen.testAndSetOrdered(0, 1))
+                emit changed();
+        }
+
+        // sleep until the next step is due
+        const qint64 wait = (qint64)((1.0f - timestep.alpha()) * stepNs);
+        usleep(std::max<qint64>(wait / 1000, 100));
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include "simulation.h"
+#include "fixedtimestep.h"
+#include "spscqueue.h"
+#include "snapshotbuffer.h"
+
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+// Runs a Simulation at its fixed rate on its own thread, so physics and game
+// logic never wait on painting. Input goes in through post() and every step
+// publishes a snapshot; both sides are lock-free and only meant for the GUI
+// thread. A step that changes what's drawn emits changed(), once until the
+// next snapshot() call, for views that paint only on demand.
+class SimulationThread : public QThread
+{
+    Q_OBJECT
+public:
+    explicit SimulationThread(Simulation* simulation, QObject *parent = 0);
+    ~SimulationThread();
+
+    // false if the queue is full and the event was dropped
+    bool post(const InputEvent &event) { return input.push(event); }
+
+    // the newest published step, valid until the next call
+    const SimulationSnapshot& snapshot()
+    {
+        unseen.storeRelease(0);
+        return snapshots.front();
+    }
+
+    // same clock as SimulationSnapshot::stepTime
+    qint64 now() const { return clock.nsecsElapsed(); }
+
+    double step() const { return timestep.step(); }
+
+    void stop();
+
+signals:
+    void changed();
+
+protected:
+    void run();
+
+private:
+    Simulation* simulation;
+    FixedTimestep timestep;
+    SpscQueue<InputEvent, 256> input;
+    SnapshotBuffer<SimulationSnapshot> snapshots;
+    SimulationSnapshot published; // a copy of the newest, to tell what changed
+    QAtomicInt unseen; // changed() was emitted since the last snapshot()
+    QElapsedTimer clock;
+    QAtomicInt stopping;
+};
+
+#endif // SIMULATIONTHREAD_H
@@ -0,0 +1,46 @@
+#ifndef SNAPSHOTBUFFER_H
+#define SNAPSHOTBUFFER_H
+
+#include <QAtomicInt>
+
+// Hands whole snapshots from one writer thread to one reader thread without
+// locks. The writer fills back() and publishes it; the reader always sees the
+// newest complete snapshot and holds on to it until it asks again. A double
+// buffer would make the writer wait for the reader to let go of the old front
+// copy, so a third slot sits between them and the two sides only ever swap
+// indices with it.
+template <typename T>
+class SnapshotBuffer
+{
+public:
+    SnapshotBuffer() : _back(0), _middle(1), _front(2) {}
+
+    // writer only
+    T& back() { return _slots[_back]; }
+
+    void publish()
+    {
+        const int old = _middle.fetchAndStoreOrdered(_back | FRESH);
+        _back = old & INDEX;
+    }
+
+    // reader only
+    const T& front()
+    {
+        if (_middle.loadAcquire() & FRESH) {
+            const int old = _middle.fetchAndStoreOrdered(_front);
+            _front = old & INDEX;
+        }
+        return _slots[_front];
+    }
+
+private:
+    enum { INDEX = 3, FRESH = 4 };
+
+    T _slots[3];
+    int _back; // writer's slot
+    QAtomicInt _middle; // last published slot, FRESH until the reader takes it
+    int _front; // reader's slot
+};
+
+#endif // SNAPSHOTBUFFER_H
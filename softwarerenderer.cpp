@@ -0,0 +1,216 @@
+#include "softwarerenderer.h"
+
+#include <algorithm>
+#include <math.h>
+
+// the same camera as MazeView's GL path
+static const float FOV = 45.0f;
+static const float NEAR_PLANE = 0.2f;
+static const float FAR_PLANE = 100.0f;
+static const float EYE_HEIGHT = 1.0f;
+static const float MARKER_WIDTH = 0.3f;
+static const float MARKER_HEIGHT = 100.0f;
+
+// red, yellow, purple and cyan for the up, down, left and right walls of a
+// cell, as masks over a grey level
+static QRgb faceColor(int wall)
+{
+    switch (wall) {
+    case WALL_UP: return 0xff0000;
+    case WALL_DOWN: return 0xffff00;
+    case WALL_LEFT: return 0xff00ff;
+    case WALL_RIGHT: return 0x00ffff;
+    }
+    return 0;
+}
+
+class SoftwareStripJob : public QRunnable
+{
+public:
+    SoftwareStripJob(SoftwareRenderer* renderer, int from, int to) : renderer(renderer), from(from), to(to)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() { renderer->renderColumns(from, to); }
+
+private:
+    SoftwareRenderer* renderer;
+    int from;
+    int to;
+};
+
+SoftwareRenderer::SoftwareRenderer(int threads) :
+    _bits(0),
+    _bytesPerLine(0),
+    _columns(0),
+    _rows(0),
+    _maze(0),
+    _markers(0)
+{
+    if (threads > 0)
+        _pool.setMaxThreadCount(threads);
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+    _pool.waitForDone();
+    qDeleteAll(_jobs);
+}
+
+void SoftwareRenderer::render(QImage &image, const Maze &maze, const PlayerPose &pose, float upDownAngle,
+                              const QVector<RenderMarker> &markers)
+{
+    const int width = image.width();
+    const int height = image.height();
+    if (width == 0 || height == 0)
+        return;
+    Q_ASSERT(image.format() == QImage::Format_RGB32);
+
+    // new strips whenever the width changes
+    if (_originX.size() != width) {
+        qDeleteAll(_jobs);
+        _jobs.clear();
+        for (int from = 0; from < width; from += SOFTWARE_STRIP)
+            _jobs.append(new SoftwareStripJob(this, from, std::min(width, from + SOFTWARE_STRIP)));
+
+        _originX.resize(width);
+        _originY.resize(width);
+        _directionX.resize(width);
+        _directionY.resize(width);
+        _hits.resize(width);
+        _wallTop.resize(width);
+        _wallBottom.resize(width);
+        _height.resize(width);
+        _heightStep.resize(width);
+        _shade.resize(width);
+        _color.resize(width);
+        _markerTop.resize(width);
+        _markerBottom.resize(width);
+        _markerColor.resize(width);
+    }
+
+    // bits() may detach, which must not happen on the pool's threads
+    _bits = image.bits();
+    _bytesPerLine = image.bytesPerLine();
+    _columns = width;
+    _rows = height;
+    _maze = &maze;
+    _pose = pose;
+    _markers = &markers;
+    _focal = 0.5f * height / tan(FOV * 0.5f * M_PI / 180.0f);
+    _horizon = 0.5f * height + tan(upDownAngle) * _focal;
+
+    // the last strip runs here rather than waiting idle
+    for (int i = 0; i < _jobs.size() - 1; i++)
+        _pool.start(_jobs[i]);
+    _jobs.last()->run();
+    _pool.waitForDone();
+}
+
+void SoftwareRenderer::renderColumns(int from, int to)
+{
+    castColumns(from, to);
+    fillColumns(from, to);
+}
+
+void SoftwareRenderer::castColumns(int from, int to)
+{
+    const int width = _columns;
+    const float forwardX = cos(_pose.angle);
+    const float forwardY = sin(_pose.angle);
+    const float rightX = forwardY;
+    const float rightY = -forwardX;
+
+    for (int c = from; c < to; c++) {
+        const float x = c + 0.5f - 0.5f * width;
+        _originX[c] = _pose.x;
+        _originY[c] = _pose.y;
+        _directionX[c] = forwardX * _focal + rightX * x;
+        _directionY[c] = forwardY * _focal + rightY * x;
+    }
+
+    // far enough for the widest column to reach the far plane
+    const float edge = 0.5f * width / _focal;
+    const float reach = FAR_PLANE * sqrt(1.0f + edge * edge);
+    RayBatch rays = { _originX.constData() + from, _originY.constData() + from,
+                      _directionX.constData() + from, _directionY.constData() + from, to - from };
+    WallRaycaster(*_maze).cast(rays, reach, _hits.data() + from);
+
+    for (int c = from; c < to; c++) {
+        const RayHit &hit = _hits[c];
+        const float x = c + 0.5f - 0.5f * width;
+
+        // distance along the view axis, which is what GL's depth is made of
+        const float depth = hit.distance * _focal / sqrt(_focal * _focal + x * x);
+        if (hit.wall == 0 || depth <= NEAR_PLANE || depth > FAR_PLANE) {
+            _wallTop[c] = _wallBottom[c] = 0.0f;
+            _shade[c] = 0.0f;
+            _color[c] = 0;
+        } else {
+            const float scale = _focal / depth;
+            _wallTop[c] = _horizon - (WALL_HEIGHT - EYE_HEIGHT) * scale;
+            _wallBottom[c] = _horizon + EYE_HEIGHT * scale;
+            _height[c] = EYE_HEIGHT + (_horizon - 0.5f) / scale;
+            _heightStep[c] = -1.0f / scale;
+            // 1 - window depth, as the wall shader multiplies by
+            _shade[c] = std::max(0.0f, 1.0f - FAR_PLANE / (FAR_PLANE - NEAR_PLANE) * (1.0f - NEAR_PLANE / depth));
+            _color[c] = faceColor(hit.wall);
+        }
+        _markerTop[c] = _markerBottom[c] = 0.0f;
+    }
+
+    // markers in front of the wall in their columns, nearest last wins
+    for (int i = 0; i < _markers->size(); i++) {
+        const RenderMarker &marker = (*_markers)[i];
+        const float relX = marker.position.x() - _pose.x;
+        const float relY = marker.position.y() - _pose.y;
+        const float depth = relX * forwardX + relY * forwardY;
+        if (depth <= NEAR_PLANE || depth > FAR_PLANE)
+            continue;
+
+        const float scale = _focal / depth;
+        const float center = 0.5f * width + (relX * rightX + relY * rightY) * scale;
+        const float half = std::max(0.5f, 0.5f * MARKER_WIDTH * scale);
+        const int first = std::max(from, (int)floor(center - half));
+        const int last = std::min(to - 1, (int)floor(center + half));
+        for (int c = first; c <= last; c++) {
+            const float x = c + 0.5f - 0.5f * width;
+            const float wallDepth = _hits[c].wall ? _hits[c].distance * _focal / sqrt(_focal * _focal + x * x) : FAR_PLANE;
+            if (depth >= wallDepth)
+                continue;
+            _markerTop[c] = _horizon - (MARKER_HEIGHT - EYE_HEIGHT) * scale;
+            _markerBottom[c] = _horizon + EYE_HEIGHT * scale;
+            _markerColor[c] = 0xff000000 | marker.color;
+        }
+    }
+}
+
+// Row by row across the strip, so every row is one contiguous run of
+// writes and the loop over columns has no branches to stop it vectorizing.
+void SoftwareRenderer::fillColumns(int from, int to)
+{
+    const int height = _rows;
+    const float* wallTop = _wallTop.constData();
+    const float* wallBottom = _wallBottom.constData();
+    const float* wallHeight = _height.constData();
+    const float* heightStep = _heightStep.constData();
+    const float* shade = _shade.constData();
+    const QRgb* color = _color.constData();
+    const float* markerTop = _markerTop.constData();
+    const float* markerBottom = _markerBottom.constData();
+    const QRgb* markerColor = _markerColor.constData();
+
+    for (int y = 0; y < height; y++) {
+        QRgb* line = (QRgb*)(_bits + (qptrdiff)y * _bytesPerLine);
+        const float row = y + 0.5f;
+        for (int c = from; c < to; c++) {
+            const bool wall = row >= wallTop[c] && row < wallBottom[c];
+            const float level = std::min(255.0f, std::max(0.0f, (wallHeight[c] + heightStep[c] * y) * shade[c] * 255.0f));
+            const QRgb grey = (QRgb)level * 0x010101;
+            const QRgb pixel = 0xff000000 | (wall ? color[c] & grey : 0);
+            const bool marker = row >= markerTop[c] && row < markerBottom[c];
+            line[c] = marker ? markerColor[c] : pixel;
+        }
+    }
+}
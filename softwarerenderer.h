@@ -0,0 +1,72 @@
+#ifndef SOFTWARERENDERER_H
+#define SOFTWARERENDERER_H
+
+#include "maze.h"
+#include "player.h"
+#include "raycaster.h"
+
+#include <QImage>
+#include <QPointF>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+
+const int SOFTWARE_STRIP = 64; // columns per job
+
+// the goal or exit post, drawn as a flat coloured pillar
+struct RenderMarker
+{
+    QPointF position; // world units
+    QRgb color;
+};
+
+class SoftwareStripJob;
+
+// The first person view without a GPU: one ray per screen column through
+// the wall grid (eight at a time where WallRaycaster can), then the columns
+// filled row by row into a QImage, SOFTWARE_STRIP columns per thread pool
+// job. Walls keep the GL view's face colours and its shading, which
+// brightens with height and falls off with depth between the same planes.
+// Looking up and down shears the view instead of tilting it.
+class SoftwareRenderer
+{
+public:
+    explicit SoftwareRenderer(int threads = 0);
+    ~SoftwareRenderer();
+
+    // image keeps its size, so it's reused frame to frame; Format_RGB32 only
+    void render(QImage &image, const Maze &maze, const PlayerPose &pose, float upDownAngle,
+                const QVector<RenderMarker> &markers = QVector<RenderMarker>());
+
+private:
+    friend class SoftwareStripJob;
+    void renderColumns(int from, int to);
+    void castColumns(int from, int to);
+    void fillColumns(int from, int to);
+
+    QThreadPool _pool;
+    QVector<SoftwareStripJob*> _jobs;
+
+    // this frame
+    uchar* _bits; // the image's rows, detached once before the jobs start
+    int _bytesPerLine;
+    int _columns;
+    int _rows;
+    const Maze* _maze;
+    PlayerPose _pose;
+    float _horizon; // screen row of the eye's height
+    float _focal; // pixels
+    const QVector<RenderMarker>* _markers;
+
+    // per column, written only by the job that owns the column
+    QVector<float> _originX, _originY, _directionX, _directionY;
+    QVector<RayHit> _hits;
+    QVector<float> _wallTop, _wallBottom; // rows, fractional
+    QVector<float> _height, _heightStep; // wall height at row 0 and per row
+    QVector<float> _shade;
+    QVector<QRgb> _color;
+    QVector<float> _markerTop, _markerBottom;
+    QVector<QRgb> _markerColor;
+};
+
+#endif // SOFTWARERENDERER_H
@@ -0,0 +1,43 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QAtomicInt>
+
+// Fixed-size ring buffer for exactly one producer thread and one consumer
+// thread. Neither side ever blocks: push() fails when the queue is full and
+// pop() when it is empty. SIZE must be a power of two.
+template <typename T, int SIZE>
+class SpscQueue
+{
+public:
+    SpscQueue() : _head(0), _tail(0) {}
+
+    // producer only
+    bool push(const T &value)
+    {
+        const int tail = _tail.loadAcquire(); // only we write it
+        if (tail - _head.loadAcquire() == SIZE)
+            return false;
+        _items[tail & (SIZE - 1)] = value;
+        _tail.storeRelease(tail + 1);
+        return true;
+    }
+
+    // consumer only
+    bool pop(T &value)
+    {
+        const int head = _head.loadAcquire(); // only we write it
+        if (head == _tail.loadAcquire())
+            return false;
+        value = _items[head & (SIZE - 1)];
+        _head.storeRelease(head + 1);
+        return true;
+    }
+
+private:
+    T _items[SIZE];
+    QAtomicInt _head; // next slot to read
+    QAtomicInt _tail; // next slot to write
+};
+
+#endif // SPSCQUEUE_H
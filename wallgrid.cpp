@@ -0,0 +1,62 @@
+#include "wallgrid.h"
+
+#include <string.h>
+
+WallGrid::WallGrid(const int width, const int height) :
+    _externalHorizontals(0),
+    _externalVerticals(0),
+    WIDTH(width),
+    HEIGHT(height)
+{
+    // columns -1 through width+1
+    _stride = (width + 3 + 63) / 64;
+
+    // everything starts as wall, halo included
+    _horizontals = QVector<quint64>((height+3) * _stride);
+    _verticals = QVector<quint64>((height+2) * _stride);
+    _horizontals.fill(~0ULL);
+    _verticals.fill(~0ULL);
+}
+
+WallGrid::WallGrid(const int width, const int height, const quint64* horizontals, const quint64* verticals) :
+    _externalHorizontals(horizontals),
+    _externalVerticals(verticals),
+    _stride((width + 3 + 63) / 64),
+    WIDTH(width),
+    HEIGHT(height)
+{
+}
+
+// take a private copy of external walls before changing them
+void WallGrid::detach()
+{
+    if (!_externalHorizontals)
+        return;
+    _horizontals = QVector<quint64>(horizontalWords());
+    _verticals = QVector<quint64>(verticalWords());
+    memcpy(_horizontals.data(), _externalHorizontals, horizontalWords() * sizeof(quint64));
+    memcpy(_verticals.data(), _externalVerticals, verticalWords() * sizeof(quint64));
+    _externalHorizontals = 0;
+    _externalVerticals = 0;
+}
+
+void WallGrid::setBit(quint64* words, int x, bool on)
+{
+    const quint64 bit = 1ULL << ((x+1) & 63);
+    if (on)
+        words[(x+1) >> 6] |= bit;
+    else
+        words[(x+1) >> 6] &= ~bit;
+}
+
+void WallGrid::setHorizontal(int x, int y, bool wall)
+{
+    detach();
+    setBit(_horizontals.data() + (y+1) * _stride, x, wall);
+}
+
+void WallGrid::setVertical(int x, int y, bool wall)
+{
+    detach();
+    setBit(_verticals.data() + (y+1) * _stride, x, wall);
+}
@@ -0,0 +1,106 @@
+#ifndef WALLGRID_H
+#define WALLGRID_H
+
+#include <QVector>
+
+enum { WALL_UP = 1, WALL_DOWN = 2, WALL_LEFT = 4, WALL_RIGHT = 8 };
+
+// zero-copy view of one row of cells, pointing straight into a WallGrid;
+// valid for columns -1 through width (the halo reads as solid wall)
+struct WallRow
+{
+    const quint64* below; // horizontal line under the row
+    const quint64* above; // horizontal line over the row
+    const quint64* sides; // vertical lines of the row
+
+    static bool bit(const quint64* words, int x) { return (words[(x+1) >> 6] >> ((x+1) & 63)) & 1; }
+
+    bool up(int x) const { return bit(above, x); }
+    bool down(int x) const { return bit(below, x); }
+    bool left(int x) const { return bit(sides, x); }
+    bool right(int x) const { return bit(sides, x+1); }
+
+    // WALL_* bits of cell x
+    int mask(int x) const
+    {
+        return (up(x) ? WALL_UP : 0) | (down(x) ? WALL_DOWN : 0) |
+               (left(x) ? WALL_LEFT : 0) | (right(x) ? WALL_RIGHT : 0);
+    }
+};
+
+// rows y-1, y and y+1, i.e. the one-cell halo around every cell of row y
+struct WallNeighborhood
+{
+    WallRow below;
+    WallRow row;
+    WallRow above;
+};
+
+// Walls packed one bit each, both planes row-major with the same stride.
+// Horizontal line y is the bottom edge of cell row y and vertical line x is
+// the left edge of column x. Column x lives at bit x+1 of its row, and a ring
+// of solid walls surrounds the maze so any cell in [-1, width] x [-1, height]
+// reads without a bounds check.
+class WallGrid
+{
+public:
+    WallGrid(const int width, const int height);
+
+    // walls stored elsewhere in this same layout, e.g. a mapped maze file;
+    // nothing is copied until the first change
+    WallGrid(const int width, const int height, const quint64* horizontals, const quint64* verticals);
+
+    int width() const { return WIDTH; }
+    int height() const { return HEIGHT; }
+    int stride() const { return _stride; } // words per row
+
+    // y in [-1, height]
+    WallRow row(int y) const
+    {
+        WallRow r;
+        r.below = horizontalRow(y);
+        r.above = horizontalRow(y+1);
+        r.sides = verticalRow(y);
+        return r;
+    }
+
+    WallNeighborhood neighborhood(int y) const
+    {
+        WallNeighborhood n;
+        n.below = row(y-1);
+        n.row = row(y);
+        n.above = row(y+1);
+        return n;
+    }
+
+    // line y in [-1, height+1]
+    const quint64* horizontalRow(int y) const { return horizontals() + (y+1) * _stride; }
+    // row y in [-1, height]
+    const quint64* verticalRow(int y) const { return verticals() + (y+1) * _stride; }
+
+    // whole planes, halo included, for saving
+    int horizontalWords() const { return (HEIGHT+3) * _stride; }
+    int verticalWords() const { return (HEIGHT+2) * _stride; }
+    const quint64* horizontals() const { return _externalHorizontals ? _externalHorizontals : _horizontals.constData(); }
+    const quint64* verticals() const { return _externalVerticals ? _externalVerticals : _verticals.constData(); }
+
+    bool horizontal(int x, int y) const { return WallRow::bit(horizontalRow(y), x); }
+    bool vertical(int x, int y) const { return WallRow::bit(verticalRow(y), x); }
+    void setHorizontal(int x, int y, bool wall);
+    void setVertical(int x, int y, bool wall);
+
+private:
+    static void setBit(quint64* words, int x, bool on);
+    void detach();
+
+    QVector<quint64> _horizontals; // height+3 lines
+    QVector<quint64> _verticals; // height+2 rows
+    const quint64* _externalHorizontals; // used instead while not null
+    const quint64* _externalVerticals;
+    int _stride;
+
+    const int WIDTH;
+    const int HEIGHT;
+};
+
+#endif // WALLGRID_H
@@ -0,0 +1,238 @@
+#include "wallmesh.h"
+
+WallMesh::WallMesh() :
+    _vertexBuffer(QGLBuffer::VertexBuffer),
+    _indexBuffer(QGLBuffer::IndexBuffer),
+    _uploadedIndices(0),
+    _stamp(0)
+{
+}
+
+void WallMesh::build(const Maze &maze)
+{
+    build(WallSegments(maze));
+}
+
+void WallMesh::build(const WallSegments &segments)
+{
+    // red, yellow, purple and cyan for up, down, left and right faces
+    static const QVector3D FACE_COLORS[4] = { QVector3D(1,0,0), QVector3D(1,1,0), QVector3D(1,0,1), QVector3D(0,1,1) };
+
+    _vertices.clear();
+    _indices.clear();
+    _faceIndices.clear();
+
+    const QVector<WallFace> &faces = segments.faces();
+    for (int i = 0; i < faces.size(); i++) {
+        const WallFace &face = faces[i];
+        _faceIndices.append(_indices.size());
+        _color = FACE_COLORS[face.direction];
+        addWall(QPoint(CELL_WIDTH*face.start.x(), CELL_WIDTH*face.start.y()), QVector2D(face.basis), CELL_WIDTH*face.length,
+                face.w1, face.w2, face.w3, face.w4, face.w5, face.w6);
+    }
+    _faceIndices.append(_indices.size());
+
+    indexCells(segments);
+}
+
+// the cell a face's run starts in, the face lying along its inside edge
+static QPoint firstCell(const WallFace &face)
+{
+    switch (face.direction) {
+    case FACE_UP: return QPoint(face.start.x(), face.start.y() - 1);
+    case FACE_DOWN: return QPoint(face.start.x() - 1, face.start.y());
+    case FACE_LEFT: return face.start;
+    case FACE_RIGHT: return QPoint(face.start.x() - 1, face.start.y() - 1);
+    }
+    return face.start;
+}
+
+void WallMesh::indexCells(const WallSegments &segments)
+{
+    const int width = segments.width();
+    const int height = segments.height();
+    const QVector<WallFace> &faces = segments.faces();
+
+    // every cell of the run, plus the cell past either end when addWall
+    // pushes the wall out into it
+    QVector<QPoint> touches; // (cell, face)
+    for (int i = 0; i < faces.size(); i++) {
+        const WallFace &face = faces[i];
+        const QPoint first = firstCell(face);
+        const int from = (!face.w3 && !face.w2) ? -1 : 0;
+        const int to = (!face.w4 && (face.w6 || !face.w5)) ? face.length : face.length - 1;
+        for (int k = from; k <= to; k++) {
+            const QPoint cell = first + face.basis * k;
+            if (cell.x() < 0 || cell.y() < 0 || cell.x() >= width || cell.y() >= height)
+                continue;
+            touches.append(QPoint(cell.y() * width + cell.x(), i));
+        }
+    }
+
+    // counting sort into per-cell lists
+    _cellFaceStart.fill(0, width * height + 1);
+    for (int i = 0; i < touches.size(); i++)
+        _cellFaceStart[touches[i].x() + 1]++;
+    for (int c = 0; c < width * height; c++)
+        _cellFaceStart[c + 1] += _cellFaceStart[c];
+
+    QVector<int> next = _cellFaceStart;
+    _cellFaces.resize(touches.size());
+    for (int i = 0; i < touches.size(); i++)
+        _cellFaces[next[touches[i].x()]++] = touches[i].y();
+
+    _faceStamp.fill(0, faces.size());
+    _stamp = 0;
+}
+
+void WallMesh::upload()
+{
+    if (!_vertexBuffer.isCreated())
+        _vertexBuffer.create();
+    if (!_indexBuffer.isCreated())
+        _indexBuffer.create();
+
+    _vertexBuffer.setUsagePattern(QGLBuffer::StaticDraw);
+    _vertexBuffer.bind();
+    _vertexBuffer.allocate(_vertices.constData(), _vertices.size() * sizeof(WallVertex));
+    _vertexBuffer.release();
+
+    _indexBuffer.setUsagePattern(QGLBuffer::StaticDraw);
+    _indexBuffer.bind();
+    _indexBuffer.allocate(_indices.constData(), _indices.size() * sizeof(GLuint));
+    _indexBuffer.release();
+
+    _uploadedIndices = _indices.size();
+}
+
+void WallMesh::bindVertices()
+{
+    _vertexBuffer.bind();
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(WallVertex), (const GLvoid*)0);
+    glColorPointer(3, GL_FLOAT, sizeof(WallVertex), (const GLvoid*)(3 * sizeof(float)));
+}
+
+void WallMesh::releaseVertices()
+{
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    _vertexBuffer.release();
+}
+
+void WallMesh::draw()
+{
+    if (_uploadedIndices == 0)
+        return;
+
+    bindVertices();
+
+    _indexBuffer.bind();
+    glDrawElements(GL_TRIANGLES, _uploadedIndices, GL_UNSIGNED_INT, (const GLvoid*)0);
+    _indexBuffer.release();
+
+    releaseVertices();
+}
+
+void WallMesh::drawCells(const QVector<int> &cells)
+{
+    if (_uploadedIndices == 0)
+        return;
+
+    // a new stamp marks faces already gathered this call
+    if (++_stamp == 0) {
+        _faceStamp.fill(0);
+        _stamp = 1;
+    }
+
+    _visibleIndices.resize(0);
+    for (int i = 0; i < cells.size(); i++) {
+        const int cell = cells[i];
+        for (int j = _cellFaceStart[cell]; j < _cellFaceStart[cell + 1]; j++) {
+            const int face = _cellFaces[j];
+            if (_faceStamp[face] == _stamp)
+                continue;
+            _faceStamp[face] = _stamp;
+            for (int k = _faceIndices[face]; k < _faceIndices[face + 1]; k++)
+                _visibleIndices.append(_indices[k]);
+        }
+    }
+    if (_visibleIndices.isEmpty())
+        return;
+
+    // the few visible indices go straight from client memory
+    bindVertices();
+    glDrawElements(GL_TRIANGLES, _visibleIndices.size(), GL_UNSIGNED_INT, _visibleIndices.constData());
+    releaseVertices();
+}
+
+void WallMesh::addQuad(QVector3D a, QVector3D b, QVector3D c, QVector3D d)
+{
+    const GLuint first = _vertices.size();
+    const QVector3D corners[4] = { a, b, c, d };
+    for (int i = 0; i < 4; i++) {
+        WallVertex v = { corners[i].x(), corners[i].y(), corners[i].z(), _color.x(), _color.y(), _color.z() };
+        _vertices.append(v);
+    }
+
+    _indices.append(first);
+    _indices.append(first + 1);
+    _indices.append(first + 2);
+    _indices.append(first);
+    _indices.append(first + 2);
+    _indices.append(first + 3);
+}
+
+void WallMesh::addWall(QPoint pXY, QVector2D basisBottom, float length, bool w1, bool w2, bool w3, bool w4, bool w5, bool w6)
+{
+    const float OFFSET = 0.1f;
+
+    QVector3D start(pXY);
+    QVector3D basisTop(0, 0, 1);
+    QVector3D basisOut = QVector3D::crossProduct(basisBottom, basisTop);
+    QVector3D basisIn = -1 * basisOut;
+
+    float wallLength = length;
+    QVector3D cornerA;
+    if (w3) {
+        cornerA = start + (basisBottom * OFFSET) + (basisOut * OFFSET);
+        wallLength -= OFFSET;
+    } else if (w2) {
+        cornerA = start + basisOut * OFFSET;
+    } else {
+        cornerA = start + (basisOut * OFFSET) + (basisBottom * -OFFSET);
+        wallLength += OFFSET;
+    }
+
+    if (w4) {
+        wallLength -= OFFSET;
+    } else if (w6) {
+        wallLength += OFFSET;
+    } else if (!w5) {
+        wallLength += OFFSET;
+    }
+
+    QVector3D cornerB = cornerA + basisBottom * wallLength;
+    QVector3D cornerC = cornerB + basisTop*WALL_HEIGHT;
+    QVector3D cornerD = cornerA + basisTop*WALL_HEIGHT;
+
+    // wall
+    addQuad(cornerA, cornerB, cornerC, cornerD);
+
+    // caps
+    if (!w1 && !w2) {
+        QVector3D in = basisIn * OFFSET;
+        QVector3D top = cornerD + in;
+        QVector3D bottom = cornerA + in;
+
+        addQuad(cornerA, cornerD, top, bottom);
+    }
+    if (!w5 && !w6) {
+        QVector3D in = basisIn * OFFSET;
+        QVector3D top = cornerC + in;
+        QVector3D bottom = cornerB + in;
+
+        addQuad(cornerB, bottom, top, cornerC);
+    }
+}
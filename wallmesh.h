@@ -0,0 +1,66 @@
+#ifndef WALLMESH_H
+#define WALLMESH_H
+
+#include "maze.h"
+#include "wallsegments.h"
+
+#include <QVector>
+#include <QVector2D>
+#include <QVector3D>
+#include <QGLBuffer>
+
+struct WallVertex
+{
+    float x, y, z;
+    float r, g, b;
+};
+
+// Every (merged) wall face and cap of a maze in one interleaved vertex buffer
+// plus a triangle index buffer. build() only touches memory, upload() and draw()
+// need the GL context to be current. Each face's triangles are contiguous and
+// indexed by the cells they reach into, so drawCells() can submit just the
+// walls of the cells that are visible.
+class WallMesh
+{
+public:
+    WallMesh();
+
+    void build(const Maze &maze);
+    void build(const WallSegments &segments);
+    void upload();
+    void draw();
+
+    // the walls of the given cells (y * width + x), each face at most once
+    void drawCells(const QVector<int> &cells);
+
+    int vertexCount() const { return _vertices.size(); }
+    int indexCount() const { return _indices.size(); }
+
+private:
+    void addWall(QPoint p, QVector2D basis, float length, bool w1, bool w2, bool w3, bool w4, bool w5, bool w6);
+    void addQuad(QVector3D a, QVector3D b, QVector3D c, QVector3D d);
+    void indexCells(const WallSegments &segments);
+    void bindVertices();
+    void releaseVertices();
+
+    QVector<WallVertex> _vertices;
+    QVector<GLuint> _indices;
+    QVector3D _color;
+
+    // face i owns _indices[_faceIndices[i] .. _faceIndices[i+1])
+    QVector<int> _faceIndices;
+    // cell c touches faces _cellFaces[_cellFaceStart[c] .. _cellFaceStart[c+1])
+    QVector<int> _cellFaceStart;
+    QVector<int> _cellFaces;
+
+    // per frame scratch for drawCells()
+    QVector<GLuint> _visibleIndices;
+    QVector<int> _faceStamp;
+    int _stamp;
+
+    QGLBuffer _vertexBuffer;
+    QGLBuffer _indexBuffer;
+    int _uploadedIndices;
+};
+
+#endif // WALLMESH_H
@@ -0,0 +1,161 @@
+#include "wallsegments.h"
+
+// faces of a cell run along these, in the order drawWall laid them out
+static const QPoint FACE_BASIS[4] = { QPoint(1,0), QPoint(-1,0), QPoint(0,1), QPoint(0,-1) };
+
+static void setFlags(WallFace &face, bool w1, bool w2, bool w3, bool w4, bool w5, bool w6)
+{
+    face.w1 = w1;
+    face.w2 = w2;
+    face.w3 = w3;
+    face.w4 = w4;
+    face.w5 = w5;
+    face.w6 = w6;
+}
+
+// the face on one side of cell (x, y), if there is a wall there
+static bool cellFace(const Maze &maze, int direction, int x, int y, WallFace &face)
+{
+    // cells around current cell (row-ordered top to bottom)
+    //   c1 c2 c3    r2
+    //   c4 c5 c6    r1, looking at c5
+    //   c7 c8 c9    r0
+    const WallNeighborhood n = maze.neighborhood(y);
+    const WallRow &r0 = n.below;
+    const WallRow &r1 = n.row;
+    const WallRow &r2 = n.above;
+    const int left = x - 1;
+    const int right = x + 1;
+
+    face.direction = direction;
+    face.basis = FACE_BASIS[direction];
+    face.length = 1;
+
+    switch (direction) {
+    case FACE_UP:
+        if (!r1.up(x))
+            return false;
+        face.start = QPoint(x, y+1);
+        setFlags(face, r2.right(left), r2.down(left), r1.right(left), r1.right(x), r1.up(right), r2.left(right));
+        return true;
+    case FACE_DOWN:
+        if (!r1.down(x))
+            return false;
+        face.start = QPoint(x+1, y);
+        setFlags(face, r0.right(x), r1.down(right), r1.right(x), r1.right(left), r1.down(left), r0.right(left));
+        return true;
+    case FACE_LEFT:
+        if (!r1.left(x))
+            return false;
+        face.start = QPoint(x, y);
+        setFlags(face, r0.up(left), r0.right(left), r1.down(x), r1.up(x), r2.left(x), r2.down(left));
+        return true;
+    case FACE_RIGHT:
+        if (!r1.right(x))
+            return false;
+        face.start = QPoint(x+1, y+1);
+        setFlags(face, r2.down(right), r2.left(right), r1.up(x), r1.down(x), r0.right(x), r0.up(right));
+        return true;
+    }
+    return false;
+}
+
+WallSegments::WallSegments(const Maze &maze) :
+    _width(maze.width()),
+    _height(maze.height()),
+    _wallCount(0),
+    _faceCount(0)
+{
+    extractSegments(maze);
+
+    extractFaces(maze, FACE_UP);
+    extractFaces(maze, FACE_DOWN);
+    extractFaces(maze, FACE_LEFT);
+    extractFaces(maze, FACE_RIGHT);
+}
+
+void WallSegments::extractSegments(const Maze &maze)
+{
+    const WallGrid &walls = maze.walls();
+    const int width = maze.width();
+    const int height = maze.height();
+
+    // horizontal lines, one row of bits each
+    for (int y = 0; y <= height; y++) {
+        const quint64* line = walls.horizontalRow(y);
+        int from = -1;
+        for (int x = 0; x <= width; x++) {
+            if (x < width && WallRow::bit(line, x)) {
+                _wallCount++;
+                if (from < 0)
+                    from = x;
+            } else if (from >= 0) {
+                WallSegment segment = { QPoint(from, y), QPoint(x, y) };
+                _segments.append(segment);
+                from = -1;
+            }
+        }
+    }
+
+    // vertical lines, still scanning row by row with one open run per line
+    QVector<int> from(width + 1, -1);
+    for (int y = 0; y <= height; y++) {
+        const quint64* row = walls.verticalRow(y);
+        for (int x = 0; x <= width; x++) {
+            if (y < height && WallRow::bit(row, x)) {
+                _wallCount++;
+                if (from[x] < 0)
+                    from[x] = y;
+            } else if (from[x] >= 0) {
+                WallSegment segment = { QPoint(x, from[x]), QPoint(x, y) };
+                _segments.append(segment);
+                from[x] = -1;
+            }
+        }
+    }
+}
+
+void WallSegments::extractFaces(const Maze &maze, int direction)
+{
+    const QPoint step = FACE_BASIS[direction];
+    const bool alongRows = step.y() == 0;
+    const int lines = alongRows ? maze.height() : maze.width();
+    const int cells = alongRows ? maze.width() : maze.height();
+    const int first = (step.x() + step.y()) > 0 ? 0 : cells - 1;
+
+    for (int line = 0; line < lines; line++) {
+        QPoint p = alongRows ? QPoint(first, line) : QPoint(line, first);
+
+        WallFace run;
+        bool open = false; // the run carries on into p
+        for (int i = 0; i < cells; i++, p += step) {
+            WallFace face;
+            if (!cellFace(maze, direction, p.x(), p.y(), face))
+                continue;
+            _faceCount++;
+
+            if (open) {
+                run.length++;
+                run.w4 = face.w4;
+                run.w5 = face.w5;
+                run.w6 = face.w6;
+            } else {
+                run = face;
+            }
+
+            // nothing meets the face on its own side and the next cell's
+            // face lines up with it
+            open = !face.w4 && face.w5;
+            if (!open)
+                _faces.append(run);
+        }
+        if (open)
+            _faces.append(run);
+    }
+}
+
+void WallSegments::report(std::ostream &out) const
+{
+    out << "walls: " << _wallCount << " edges -> " << _segments.size() << " segments, "
+        << _faceCount << " faces -> " << _faces.size() << " merged faces" << std::endl;
+}
@@ -0,0 +1,70 @@
+#ifndef WALLSEGMENTS_H
+#define WALLSEGMENTS_H
+
+#include "maze.h"
+
+#include <QVector>
+#include <QPoint>
+
+#include <iostream>
+
+enum { FACE_UP, FACE_DOWN, FACE_LEFT, FACE_RIGHT };
+
+// a straight run of walls along a grid line, in cell units
+struct WallSegment
+{
+    QPoint from;
+    QPoint to;
+};
+
+// a run of wall faces seen from inside one row or column of cells. start and
+// basis are in cell units, and the w1..w6 junction flags are the ones the
+// first (w1..w3) and last (w4..w6) cell of the run would have on their own:
+//   w1/w2: wall across / continuing beyond the start, outside the run's cells
+//   w3:    wall across the start on the run's side
+//   w4:    wall across the end on the run's side
+//   w5/w6: wall continuing beyond / across the end, outside the run's cells
+struct WallFace
+{
+    QPoint start;
+    QPoint basis;
+    int direction; // FACE_*
+    int length; // cells
+    bool w1, w2, w3, w4, w5, w6;
+};
+
+// Merges collinear walls into maximal runs. segments() joins every unbroken
+// run along a grid line (for collision); faces() only joins faces where no
+// wall meets them from their own side, so the corner offsets at junctions
+// come out the same as drawing each cell's faces one by one.
+class WallSegments
+{
+public:
+    explicit WallSegments(const Maze &maze);
+
+    const QVector<WallSegment>& segments() const { return _segments; }
+    const QVector<WallFace>& faces() const { return _faces; }
+
+    // size of the maze the walls came from, in cells
+    int width() const { return _width; }
+    int height() const { return _height; }
+
+    // primitive counts before merging
+    int wallCount() const { return _wallCount; }
+    int faceCount() const { return _faceCount; }
+
+    void report(std::ostream &out) const;
+
+private:
+    void extractSegments(const Maze &maze);
+    void extractFaces(const Maze &maze, int direction);
+
+    QVector<WallSegment> _segments;
+    QVector<WallFace> _faces;
+    int _width;
+    int _height;
+    int _wallCount;
+    int _faceCount;
+};
+
+#endif // WALLSEGMENTS_H